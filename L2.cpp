@@ -1,27 +1,26 @@
 #include "L2.h"
-#include <sstream>
-#include <iomanip>
+#include "checksum.hpp"
+#include "packet_format.hpp"
 #include <cstring>
 #include <vector>
 #include <iostream> // Include iostream for std::cout
+#include <stdexcept>
+#include <utility>
 
 using namespace common;
 
 l2_packet::l2_packet(const uint8_t src_mac_[MAC_SIZE], const uint8_t dst_mac_[MAC_SIZE], uint16_t checksum, l3_packet payload)
-    : checksum(checksum), payload(payload) {
-    std::memcpy(src_mac, src_mac_, MAC_SIZE);
-    std::memcpy(dst_mac, dst_mac_, MAC_SIZE);
-}
+    : src_mac(pack_mac(src_mac_)), dst_mac(pack_mac(dst_mac_)), checksum(checksum), payload(std::move(payload)) {}
 
 uint16_t l2_packet::calc_checksum(const l2_packet& pkt) {
     uint16_t sum = 0;
     // Sum MAC addresses
-    for (int i = 0; i < MAC_SIZE; ++i) sum += pkt.src_mac[i];
-    for (int i = 0; i < MAC_SIZE; ++i) sum += pkt.dst_mac[i];
+    sum += sum_u48(pkt.src_mac);
+    sum += sum_u48(pkt.dst_mac);
     
     // Sum IP addresses
-    for (int i = 0; i < IP_V4_SIZE; ++i) sum += pkt.payload.src_ip[i];
-    for (int i = 0; i < IP_V4_SIZE; ++i) sum += pkt.payload.dst_ip[i];
+    sum += sum_u32(pkt.payload.src_ip);
+    sum += sum_u32(pkt.payload.dst_ip);
     
     // Sum TTL
     sum += pkt.payload.ttl;
@@ -39,32 +38,34 @@ uint16_t l2_packet::calc_checksum(const l2_packet& pkt) {
     sum += (pkt.payload.payload.address & 0xFF); // Low byte
     
     // Sum L4 data bytes
-    for (const auto& byte : pkt.payload.payload.data) {
-        sum += byte;
-    }
+    sum += pkt.payload.payload.data_checksum();
     
     return sum;
 }
 
 std::string l2_packet::mac_to_str(const uint8_t mac[MAC_SIZE]) {
-    std::ostringstream oss;
-    for (int i = 0; i < MAC_SIZE; ++i) {
-        oss << std::nouppercase << std::setw(2) << std::setfill('0') << std::hex << (int)mac[i];
-        if (i < MAC_SIZE - 1) oss << ":";
-    }
-    return oss.str();
+    char buf[MAC_STR_SIZE];
+    return std::string(buf, format_mac(buf, mac));
+}
+
+bool l2_packet::validate_packet(open_port_vec, uint8_t ip[IP_V4_SIZE], uint8_t mask, uint8_t mac[MAC_SIZE]) {
+    return validate_packet(nic_context(ip, mask, mac));
 }
 
-bool l2_packet::validate_packet(open_port_vec, uint8_t[], uint8_t, uint8_t mac[MAC_SIZE]) {
-    if (std::memcmp(dst_mac, mac, MAC_SIZE) != 0) return false;
+bool l2_packet::proccess_packet(open_port_vec &open_ports, uint8_t ip[IP_V4_SIZE], uint8_t mask, memory_dest &dst) {
+    return payload.proccess_packet(open_ports, ip, mask, dst);
+}
+
+bool l2_packet::validate_packet(const nic_context &ctx) const {
+    if (dst_mac != ctx.mac_addr) return false;
     if (calc_checksum(*this) != checksum) return false;
     return true;
 }
 
-bool l2_packet::proccess_packet(open_port_vec &open_ports, uint8_t ip[IP_V4_SIZE], uint8_t mask, memory_dest &dst) {
+bool l2_packet::proccess_packet(const nic_context &ctx, open_port_vec &open_ports, memory_dest &dst) {
     // L2 validation should be done before calling proccess_packet
     // Here we just delegate to the L3 layer
-    return payload.proccess_packet(open_ports, ip, mask, dst);
+    return payload.proccess_packet(ctx, open_ports, dst);
 }
 
 bool l2_packet::as_string(std::string &packet) {
@@ -73,32 +74,28 @@ bool l2_packet::as_string(std::string &packet) {
     return payload.as_string(packet);
 }
 
-l2_packet::l2_packet(const std::string& str) : payload(get_l3_string(str))
-{
-    std::string src_mac_str = extract_between_delimiters(str, '|', 0, 0);
-    std::string dst_mac_str = extract_between_delimiters(str, '|', 1, 1);
-    
-    // Extract the L2 checksum (last field after the last '|')
-    size_t last_delim = str.find_last_of('|');
-    std::string cs_str = str.substr(last_delim + 1);
-    
-    // Parse MACs first
-    std::istringstream iss1(src_mac_str), iss2(dst_mac_str);
-    for (int i = 0; i < MAC_SIZE; ++i) {
-        std::string byte;
-        std::getline(iss1, byte, ':');
-        src_mac[i] = static_cast<uint8_t>(std::stoul(byte, nullptr, 16));
-        std::getline(iss2, byte, ':');
-        dst_mac[i] = static_cast<uint8_t>(std::stoul(byte, nullptr, 16));
-    }
-    checksum = static_cast<uint16_t>(std::stoi(cs_str));
+size_t l2_packet::string_size() const {
+    return payload.string_size();
+}
+
+char *l2_packet::write_string(char *out) const {
+    // Same as as_string: only the L3 content is forwarded
+    return payload.write_string(out);
 }
 
-std::string l2_packet::get_l3_string(const std::string& str) {
-    // Extract L3 string (from after second '|' to before last '|')
-    size_t last_delim = str.find_last_of('|');
-    size_t second_delim = str.find('|');
-    second_delim = str.find('|', second_delim + 1);
-    std::string l3_str = str.substr(second_delim + 1, last_delim - second_delim - 1);
-    return l3_str;
+l2_packet::l2_packet(const std::string& str) : l2_packet(packet_fields(str), 0) {}
+
+l2_packet::l2_packet(const packet_fields& fields, size_t first, std::pmr::memory_resource *mem, bool keep_text)
+    : payload(fields, first + 2, mem, keep_text) // L3 fields
+{
+    // The L2 checksum is the last field of the line
+    uint8_t src[MAC_SIZE], dst[MAC_SIZE];
+    long long cs_val;
+    if (!parse_mac(fields[first], src) || !parse_mac(fields[first + 1], dst) ||
+        !parse_dec(fields[fields.size() - 1], cs_val))
+        throw std::invalid_argument("l2_packet: malformed header");
+
+    src_mac = pack_mac(src);
+    dst_mac = pack_mac(dst);
+    checksum = static_cast<uint16_t>(cs_val);
 }
\ No newline at end of file
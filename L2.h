@@ -1,5 +1,5 @@
 #pragma once
-#include "packets.hpp"
+#include "nic_packet.hpp"
 #include "L3.h"
 #include <cstdint>
 #include <string>
@@ -8,10 +8,10 @@
  * @class l2_packet
  * @brief Represents a Layer 2 (Data Link) packet for the NIC simulation.
  *
- * This class implements the generic_packet interface for L2 packets,
+ * This class implements the nic_packet interface for L2 packets,
  * providing validation, processing, and string conversion functionalities.
  */
-class l2_packet : public generic_packet {
+class l2_packet final : public nic_packet {
 public:
     /**
      * @fn l2_packet
@@ -20,7 +20,7 @@ public:
      * @param [in] src_mac  - Source MAC address (array of 6 bytes).
      * @param [in] dst_mac  - Destination MAC address (array of 6 bytes).
      * @param [in] checksum - Checksum value.
-     * @param [in] payload  - L3 payload packet.
+     * @param [in] payload  - L3 payload packet, moved into the packet.
      */
     l2_packet(const uint8_t src_mac[MAC_SIZE], const uint8_t dst_mac[MAC_SIZE], uint16_t checksum, l3_packet payload);
 
@@ -32,6 +32,20 @@ public:
      */
     l2_packet(const std::string& str);
 
+    /**
+     * @fn l2_packet
+     * @brief Constructor for L2 packet from an already tokenized string.
+     *
+     * @param [in] fields - Tokenized packet string.
+     * @param [in] first  - Index of the first L2 field (source MAC).
+     * @param [in] mem    - Memory resource to allocate the L4 data buffer from.
+     * @param [in] keep_text - Keep canonical L4 data as a view of its hex
+     *                         text (see l4_packet::data_text). The string
+     *                         must then outlive the packet.
+     */
+    l2_packet(const packet_fields& fields, size_t first,
+              std::pmr::memory_resource *mem = std::pmr::get_default_resource(), bool keep_text = false);
+
     /**
      * @fn validate_packet
      * @brief Check whether the packet is valid.
@@ -58,6 +72,28 @@ public:
      */
     bool proccess_packet(open_port_vec &open_ports, uint8_t ip[IP_V4_SIZE], uint8_t mask, memory_dest &dst) override;
 
+    /**
+     * @fn validate_packet
+     * @brief Check whether the packet is valid.
+     *
+     * @param [in] ctx - NIC configuration.
+     *
+     * @return true if the packet is valid, false otherwise.
+     */
+    bool validate_packet(const nic_context &ctx) const override;
+
+    /**
+     * @fn proccess_packet
+     * @brief Modify the packet and return the memory location it should be stored in.
+     *
+     * @param [in] ctx            - NIC configuration.
+     * @param [in,out] open_ports - Vector containing all the NIC's open ports.
+     * @param [out] dst           - Reference to enum indicating the memory space.
+     *
+     * @return true on success, false on failure.
+     */
+    bool proccess_packet(const nic_context &ctx, open_port_vec &open_ports, memory_dest &dst) override;
+
     /**
      * @fn as_string
      * @brief Convert the packet to string.
@@ -68,6 +104,22 @@ public:
      */
     bool as_string(std::string &packet) override;
 
+    /**
+     * @fn string_size
+     * @brief Upper bound on the length of the packet's string representation.
+     */
+    size_t string_size() const override;
+
+    /**
+     * @fn write_string
+     * @brief Write the packet's string representation into a buffer.
+     *
+     * @param [out] out - Output buffer, at least string_size() bytes.
+     *
+     * @return End of the written text.
+     */
+    char *write_string(char *out) const override;
+
     /**
      * @fn calc_checksum
      * @brief Calculate the checksum for the packet.
@@ -88,20 +140,16 @@ public:
      */
     static std::string mac_to_str(const uint8_t mac[MAC_SIZE]);
 
-private:
-    /**
-     * @fn get_l3_string
-     * @brief Extract L3 string from L2 packet string.
-     *
-     * @param [in] str - The L2 packet string.
-     *
-     * @return The L3 string.
-     */
-    static std::string get_l3_string(const std::string& str);
-
 public:
-    uint8_t src_mac[MAC_SIZE];    /**< Source MAC address */
-    uint8_t dst_mac[MAC_SIZE];    /**< Destination MAC address */
-    uint16_t checksum;            /**< Checksum */
+    uint64_t src_mac : 48;        /**< Source MAC address, packed by pack_mac */
+    uint64_t dst_mac : 48;        /**< Destination MAC address, packed by pack_mac */
+    uint16_t checksum;            /**< Checksum, in the bits dst_mac leaves free */
     l3_packet payload;            /**< Layer 3 packet payload */
-};
\ No newline at end of file
+};
+
+// Header bytes only, not the whole packet: the L2 and L3 fields of an
+// l2_packet plus the L4 vtable pointer, ports and address must fit in its
+// first cache line. The L4 payload_buffer follows them, so the packet
+// itself is larger (128 bytes with a 32-byte DATA_ARR_SIZE)
+static_assert(sizeof(l2_packet) - sizeof(l4_packet) + sizeof(void *) + 2 * sizeof(uint16_t) + sizeof(uint32_t) <= 64,
+              "L2, L3 and L4 headers must fit in one cache line");
\ No newline at end of file
@@ -1,33 +1,39 @@
 #include "L3.h"
-#include <sstream>
-#include <iomanip>
+#include "checksum.hpp"
+#include "packet_format.hpp"
 #include <cstring>
 #include <vector>
 #include <iostream> // For debug output
+#include <stdexcept>
+#include <utility>
 
 using namespace common;
 
-static bool ip_in_net(const uint8_t ip[IP_V4_SIZE], const uint8_t net_ip[IP_V4_SIZE], uint8_t mask) {
-    int bits = mask;
-    for (int i = 0; i < IP_V4_SIZE; ++i) {
-        uint8_t mask_byte = bits >= 8 ? 0xFF : (bits == 0 ? 0 : (0xFF << (8 - bits)));
-        if ((ip[i] & mask_byte) != (net_ip[i] & mask_byte)) return false;
-        bits = bits > 8 ? bits - 8 : 0;
-    }
-    return true;
+/**
+ * @fn adjust_checksum
+ * @brief Update a checksum after a field changed, without re-summing the
+ *        whole packet. The checksum is a plain mod 2^16 byte sum, so the
+ *        change of the field's byte sum can simply be applied to it.
+ *
+ * @param [in] checksum - Checksum before the change (must be valid).
+ * @param [in] old_sum  - Byte sum of the field before the change.
+ * @param [in] new_sum  - Byte sum of the field after the change.
+ *
+ * @return The checksum calc_checksum would return after the change.
+ */
+static uint16_t adjust_checksum(uint16_t checksum, uint32_t old_sum, uint32_t new_sum) {
+    return static_cast<uint16_t>(checksum - old_sum + new_sum);
 }
 
 l3_packet::l3_packet(const uint8_t src_ip_[IP_V4_SIZE], const uint8_t dst_ip_[IP_V4_SIZE], uint8_t ttl, uint16_t checksum, l4_packet payload)
-    : ttl(ttl), checksum(checksum), payload(payload) {
-    std::memcpy(src_ip, src_ip_, IP_V4_SIZE);
-    std::memcpy(dst_ip, dst_ip_, IP_V4_SIZE);
-}
+    : src_ip(pack_ipv4(src_ip_)), dst_ip(pack_ipv4(dst_ip_)), ttl(ttl), checksum(checksum),
+      payload(std::move(payload)) {}
 
 uint16_t l3_packet::calc_checksum(const l3_packet& pkt) {
     uint16_t sum = 0;
     // Sum IP addresses
-    for (int i = 0; i < IP_V4_SIZE; ++i) sum += pkt.src_ip[i];
-    for (int i = 0; i < IP_V4_SIZE; ++i) sum += pkt.dst_ip[i];
+    sum += sum_u32(pkt.src_ip);
+    sum += sum_u32(pkt.dst_ip);
     // Sum TTL
     sum += pkt.ttl;
 
@@ -39,94 +45,107 @@ uint16_t l3_packet::calc_checksum(const l3_packet& pkt) {
     sum += (pkt.payload.address >> 8);          // High byte
     sum += (pkt.payload.address & 0xFF);        // Low byte
     
-    // Sum L4 data bytes - this was missing!
-    for (const auto& byte : pkt.payload.data) {
-        sum += byte;
-    }
+    // Sum L4 data bytes
+    sum += pkt.payload.data_checksum();
         
     return sum;
 }
 
-bool l3_packet::validate_packet(open_port_vec, uint8_t[], uint8_t, uint8_t[]) {
+bool l3_packet::validate_packet(open_port_vec, uint8_t ip[IP_V4_SIZE], uint8_t mask, uint8_t mac[MAC_SIZE]) {
+    return validate_packet(nic_context(ip, mask, mac));
+}
+
+bool l3_packet::proccess_packet(open_port_vec &open_ports, uint8_t ip[IP_V4_SIZE], uint8_t mask, memory_dest &dst) {
+    nic_context ctx(ip, mask, nullptr);
+    if (!validate_packet(ctx)) return false;
+
+    l3_route r = route(src_ip, dst_ip, ctx);
+    int port_slot = (r == ROUTE_LOCAL) ? open_port_table::scan(open_ports, payload.src_port, payload.dst_port) : -1;
+    return apply_route(r, port_slot, ctx, open_ports, dst);
+}
+
+bool l3_packet::validate_packet(const nic_context &) const {
     bool valid_checksum = (calc_checksum(*this) == checksum);
     bool valid_ttl = (ttl > 0);
     return (valid_checksum && valid_ttl);
 }
 
-bool l3_packet::proccess_packet(open_port_vec &open_ports, uint8_t ip[IP_V4_SIZE], uint8_t mask, memory_dest &dst) {
-    bool src_in = ip_in_net(src_ip, ip, mask);
-    bool dst_in = ip_in_net(dst_ip, ip, mask);
-    bool dst_is_me = std::memcmp(dst_ip, ip, IP_V4_SIZE) == 0;
-
-    if (!validate_packet(open_ports, ip, mask, nullptr)) return false;
-
-    if (dst_is_me) { // For me (write to LOCAL DRAM)
-        if (payload.proccess_packet(open_ports, ip, mask, dst)) {
-            // Only write to LOCAL DRAM if L4 ports match
-            return true;
-        }
-        // If not written to LOCAL DRAM, drop the packet (do not forward)
-        return false;
-    }
-    if (!src_in && dst_in) { // Incoming
+bool l3_packet::proccess_packet(const nic_context &ctx, open_port_vec &open_ports, memory_dest &dst) {
+    if (!validate_packet(ctx)) return false;
+
+    l3_route r = route(src_ip, dst_ip, ctx);
+    int port_slot = (r == ROUTE_LOCAL) ? ctx.ports.find(payload.src_port, payload.dst_port) : -1;
+    return apply_route(r, port_slot, ctx, open_ports, dst);
+}
+
+bool l3_packet::apply_route(l3_route route, int port_slot, const nic_context &ctx, open_port_vec &open_ports, memory_dest &dst) {
+    // The checksum has been validated, so the forwarding branches below
+    // update it incrementally from the fields they change.
+    switch (route) {
+    case ROUTE_LOCAL:
+        // Only write to LOCAL DRAM if L4 ports match, otherwise drop the
+        // packet (do not forward)
+        if (port_slot == -1) return false;
+        return payload.write_dram(open_ports[port_slot], dst);
+    case ROUTE_INCOMING:
         if (--ttl == 0) return false;
-        checksum = calc_checksum(*this);
+        checksum = adjust_checksum(checksum, ttl + 1, ttl);
         dst = RQ;
         return true;
-    }
-    if (src_in && !dst_in) { // Outgoing
-        std::memcpy(src_ip, ip, IP_V4_SIZE);
+    case ROUTE_OUTGOING: {
+        uint32_t old_src_sum = sum_u32(src_ip);
+        src_ip = ctx.ip_addr;
         if (--ttl == 0) return false;
-        checksum = calc_checksum(*this);
+        checksum = adjust_checksum(checksum, old_src_sum + ttl + 1, sum_u32(src_ip) + ttl);
         dst = TQ;
         return true;
     }
-    if (!src_in && !dst_in) { // Transit
+    case ROUTE_TRANSIT:
         if (--ttl == 0) return false;
-        checksum = calc_checksum(*this);
+        checksum = adjust_checksum(checksum, ttl + 1, ttl);
         dst = TQ;
         return true;
+    default:
+        // Both in net or not relevant
+        return false;
     }
-    // Both in net or not relevant
-    return false;
 }
 
 bool l3_packet::as_string(std::string &packet) {
-    std::ostringstream oss;
-    for (int i = 0; i < IP_V4_SIZE; ++i) {
-        oss << (int)src_ip[i];
-        if (i < IP_V4_SIZE - 1) oss << ".";
-    }
-    oss << "|";
-    for (int i = 0; i < IP_V4_SIZE; ++i) {
-        oss << (int)dst_ip[i];
-        if (i < IP_V4_SIZE - 1) oss << ".";
-    }
-    oss << "|" << (int)ttl << "|" << checksum << "|";
-    std::string l4str;
-    payload.as_string(l4str);
-    oss << l4str;
-    packet = oss.str();
+    packet.resize(string_size());
+    packet.resize(write_string(&packet[0]) - packet.data());
     return true;
 }
 
-l3_packet::l3_packet(const std::string& str)
-    : payload(extract_between_delimiters(str, '|', 4, -1)) // L4 string
+size_t l3_packet::string_size() const {
+    return 2 * IP_STR_MAX_SIZE + 2 * DEC_U32_MAX_SIZE + 4 + payload.string_size();
+}
+
+char *l3_packet::write_string(char *out) const {
+    out = format_ip(out, src_ip);
+    *out++ = '|';
+    out = format_ip(out, dst_ip);
+    *out++ = '|';
+    out = format_dec(out, ttl);
+    *out++ = '|';
+    out = format_dec(out, checksum);
+    *out++ = '|';
+    return payload.write_string(out);
+}
+
+l3_packet::l3_packet(const std::string& str) : l3_packet(packet_fields(str), 0) {}
+
+l3_packet::l3_packet(const packet_fields& fields, size_t first, std::pmr::memory_resource *mem, bool keep_text)
+    : payload(fields, first + 4, mem, keep_text) // L4 fields
 {
-    std::string src_ip_str = extract_between_delimiters(str, '|', 0, 0);
-    std::string dst_ip_str = extract_between_delimiters(str, '|', 1, 1);
-    std::string ttl_str    = extract_between_delimiters(str, '|', 2, 2);
-    std::string cs_str     = extract_between_delimiters(str, '|', 3, 3);
-
-    // Parse IPs
-    std::istringstream iss1(src_ip_str), iss2(dst_ip_str);
-    for (int i = 0; i < IP_V4_SIZE; ++i) {
-        std::string byte;
-        std::getline(iss1, byte, '.');
-        src_ip[i] = static_cast<uint8_t>(std::stoi(byte));
-        std::getline(iss2, byte, '.');
-        dst_ip[i] = static_cast<uint8_t>(std::stoi(byte));
-    }
-    ttl = static_cast<uint8_t>(std::stoi(ttl_str));
-    checksum = static_cast<uint16_t>(std::stoi(cs_str));
+    uint8_t src[IP_V4_SIZE], dst[IP_V4_SIZE];
+    long long ttl_val, cs_val;
+    if (!parse_ip(fields[first], src) || !parse_ip(fields[first + 1], dst) ||
+        !parse_dec(fields[first + 2], ttl_val) || !parse_dec(fields[first + 3], cs_val))
+        throw std::invalid_argument("l3_packet: malformed header");
+
+    src_ip = pack_ipv4(src);
+    dst_ip = pack_ipv4(dst);
+    ttl = static_cast<uint8_t>(ttl_val);
+    checksum = static_cast<uint16_t>(cs_val);
 }
\ No newline at end of file
@@ -1,17 +1,29 @@
 #pragma once
-#include "packets.hpp"
+#include "nic_packet.hpp"
 #include "L4.h"
 #include <cstdint>
 #include <string>
 
+/**
+ * @enum l3_route
+ * @brief Forwarding decision for an L3 packet.
+ */
+enum l3_route {
+    ROUTE_DROP,      /**< Both ends in the NIC's network: drop */
+    ROUTE_LOCAL,     /**< Addressed to the NIC: write to LOCAL DRAM */
+    ROUTE_INCOMING,  /**< From outside into the network: RQ */
+    ROUTE_OUTGOING,  /**< From the network to outside: rewrite src, TQ */
+    ROUTE_TRANSIT    /**< Neither end in the network: TQ */
+};
+
 /**
  * @class l3_packet
  * @brief Represents a Layer 3 (Network) packet for the NIC simulation.
  *
- * This class implements the generic_packet interface for L3 packets,
+ * This class implements the nic_packet interface for L3 packets,
  * providing validation, processing, and string conversion functionalities.
  */
-class l3_packet : public generic_packet {
+class l3_packet final : public nic_packet {
 public:
     /**
      * @fn l3_packet
@@ -21,7 +33,7 @@ public:
      * @param [in] dst_ip - Destination IPv4 address (array of 4 bytes).
      * @param [in] ttl - Time To Live value.
      * @param [in] checksum - Checksum value.
-     * @param [in] payload - L4 payload packet.
+     * @param [in] payload - L4 payload packet, moved into the packet.
      */
     l3_packet(const uint8_t src_ip[IP_V4_SIZE], const uint8_t dst_ip[IP_V4_SIZE], uint8_t ttl, uint16_t checksum, l4_packet payload);
 
@@ -33,6 +45,20 @@ public:
      */
     l3_packet(const std::string& str);
 
+    /**
+     * @fn l3_packet
+     * @brief Constructor for L3 packet from an already tokenized string.
+     *
+     * @param [in] fields - Tokenized packet string.
+     * @param [in] first  - Index of the first L3 field (source IP).
+     * @param [in] mem    - Memory resource to allocate the L4 data buffer from.
+     * @param [in] keep_text - Keep canonical L4 data as a view of its hex
+     *                         text (see l4_packet::data_text). The string
+     *                         must then outlive the packet.
+     */
+    l3_packet(const packet_fields& fields, size_t first,
+              std::pmr::memory_resource *mem = std::pmr::get_default_resource(), bool keep_text = false);
+
     /**
      * @fn validate_packet
      * @brief Check whether the packet is valid.
@@ -59,6 +85,72 @@ public:
      */
     bool proccess_packet(open_port_vec &open_ports, uint8_t ip[IP_V4_SIZE], uint8_t mask, memory_dest &dst) override;
 
+    /**
+     * @fn validate_packet
+     * @brief Check whether the packet is valid.
+     *
+     * @param [in] ctx - NIC configuration.
+     *
+     * @return true if the packet is valid, false otherwise.
+     */
+    bool validate_packet(const nic_context &ctx) const override;
+
+    /**
+     * @fn proccess_packet
+     * @brief Modify the packet and return the memory location it should be stored in.
+     *
+     * @param [in] ctx            - NIC configuration.
+     * @param [in,out] open_ports - Vector containing all the NIC's open ports.
+     * @param [out] dst           - Reference to enum indicating the memory space.
+     *
+     * @return true on success, false on failure.
+     */
+    bool proccess_packet(const nic_context &ctx, open_port_vec &open_ports, memory_dest &dst) override;
+
+    /**
+     * @fn route
+     * @brief Forwarding decision for a packet between two addresses.
+     *
+     *        The destination is first looked up in the routing table; a
+     *        prefix routed to RQ, TQ or DROP decides directly (packets from
+     *        the NIC's network to TQ still get their source rewritten). The
+     *        NIC's own network and unrouted addresses are classified by
+     *        whether each end is inside the NIC's network.
+     *
+     * @param [in] src_ip - Source address, packed by pack_ipv4.
+     * @param [in] dst_ip - Destination address, packed by pack_ipv4.
+     * @param [in] ctx    - NIC configuration.
+     *
+     * @return The route the packet takes.
+     */
+    static l3_route route(uint32_t src_ip, uint32_t dst_ip, const nic_context &ctx) {
+        if (dst_ip == ctx.ip_addr) return ROUTE_LOCAL;
+        bool src_in = ((src_ip ^ ctx.ip_addr) & ctx.netmask) == 0;
+        switch (ctx.routes.lookup(dst_ip)) {
+        case ACTION_RQ:   return ROUTE_INCOMING;
+        case ACTION_TQ:   return src_in ? ROUTE_OUTGOING : ROUTE_TRANSIT;
+        case ACTION_DROP: return ROUTE_DROP;
+        default:          break;
+        }
+        bool dst_in = ((dst_ip ^ ctx.ip_addr) & ctx.netmask) == 0;
+        if (src_in == dst_in) return src_in ? ROUTE_DROP : ROUTE_TRANSIT;
+        return src_in ? ROUTE_OUTGOING : ROUTE_INCOMING;
+    }
+
+    /**
+     * @fn apply_route
+     * @brief Process an already validated packet along a precomputed route.
+     *
+     * @param [in] route          - Route of the packet.
+     * @param [in] port_slot      - Index of the packet's open port (ROUTE_LOCAL), -1 if none.
+     * @param [in] ctx            - NIC configuration.
+     * @param [in,out] open_ports - Vector containing all the NIC's open ports.
+     * @param [out] dst           - Reference to enum indicating the memory space.
+     *
+     * @return true on success, false if the packet is dropped.
+     */
+    bool apply_route(l3_route route, int port_slot, const nic_context &ctx, open_port_vec &open_ports, memory_dest &dst);
+
     /**
      * @fn as_string
      * @brief Convert the packet to string.
@@ -69,6 +161,22 @@ public:
      */
     bool as_string(std::string &packet) override;
 
+    /**
+     * @fn string_size
+     * @brief Upper bound on the length of the packet's string representation.
+     */
+    size_t string_size() const override;
+
+    /**
+     * @fn write_string
+     * @brief Write the packet's string representation into a buffer.
+     *
+     * @param [out] out - Output buffer, at least string_size() bytes.
+     *
+     * @return End of the written text.
+     */
+    char *write_string(char *out) const override;
+
     /**
      * @fn calc_checksum
      * @brief Calculate the checksum for the packet.
@@ -79,8 +187,8 @@ public:
      */
     static uint16_t calc_checksum(const l3_packet& pkt);
 
-    uint8_t src_ip[IP_V4_SIZE];   /**< Source IPv4 address */
-    uint8_t dst_ip[IP_V4_SIZE];   /**< Destination IPv4 address */
+    uint32_t src_ip;              /**< Source IPv4 address, packed by pack_ipv4 */
+    uint32_t dst_ip;              /**< Destination IPv4 address, packed by pack_ipv4 */
     uint8_t ttl;                  /**< Time To Live */
     uint16_t checksum;            /**< Checksum */
     l4_packet payload;            /**< L4 payload packet */
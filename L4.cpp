@@ -1,64 +1,113 @@
 #include "L4.h"
 #include "common.hpp"
-#include <sstream>
-#include <iomanip>
+#include "packet_format.hpp"
+#include "checksum.hpp"
+#include <cstring>
 #include <vector>
 #include <cstdint>
 #include <iostream> // Include iostream for std::cout
+#include <stdexcept>
 
 using namespace common;
 
 l4_packet::l4_packet(uint16_t src_port, uint16_t dst_port, uint32_t address, const std::vector<uint8_t>& data)
-    : src_port(src_port), dst_port(dst_port), address(address), data(data) {}
+    : src_port(src_port), dst_port(dst_port), address(address), data(data.data(), data.size()) {}
 
-// New: parse from string using extract_between_delimiters
-l4_packet::l4_packet(const std::string& str) {
-    std::string src_port_str = extract_between_delimiters(str, '|', 0, 0);
-    std::string dst_port_str = extract_between_delimiters(str, '|', 1, 1);
-    std::string address_str  = extract_between_delimiters(str, '|', 2, 2);
-    std::string data_str     = extract_between_delimiters(str, '|', 3, -1);
+l4_packet::l4_packet(uint16_t src_port, uint16_t dst_port, uint32_t address, payload_buffer&& data)
+    : src_port(src_port), dst_port(dst_port), address(address), data(std::move(data)) {}
 
-    src_port = static_cast<uint16_t>(std::stoi(src_port_str));
-    dst_port = static_cast<uint16_t>(std::stoi(dst_port_str));
-    address  = static_cast<uint32_t>(std::stoul(address_str));
+l4_packet::l4_packet(const std::string& str) : l4_packet(packet_fields(str), 0) {}
 
-    // Parse hex bytes
-    data.clear();
-    std::istringstream iss(data_str);
-    std::string byte_str;
-    while (iss >> byte_str) {
-        data.push_back(static_cast<uint8_t>(std::stoul(byte_str, nullptr, 16)));
+l4_packet::l4_packet(const packet_fields& fields, size_t first, std::pmr::memory_resource *mem, bool keep_text)
+    : data(mem) {
+    long long src, dst, addr;
+    if (!parse_dec(fields[first], src) || !parse_dec(fields[first + 1], dst) ||
+        !parse_dec(fields[first + 2], addr))
+        throw std::invalid_argument("l4_packet: malformed header");
+
+    src_port = static_cast<uint16_t>(src);
+    dst_port = static_cast<uint16_t>(dst);
+    address  = static_cast<uint32_t>(addr);
+
+    // Canonical data is left as text: forwarding copies it verbatim and
+    // checksums and DRAM writes read it in place
+    std::string_view text = fields[first + 3];
+    if (keep_text && is_canonical_hex(text)) {
+        data_text = text;
+        return;
     }
+
+    // Parse hex bytes
+    if (!parse_hex_bytes(text, data))
+        throw std::invalid_argument("l4_packet: malformed data");
 }
 
-bool l4_packet::validate_packet(open_port_vec open_ports, uint8_t[], uint8_t, uint8_t[]) {
-    for (const auto& port : open_ports) {
-        if (port.src_prt == src_port && port.dst_prt == dst_port)
-            return true;
-    }
-    return false;
+bool l4_packet::validate_packet(open_port_vec open_ports, uint8_t *, uint8_t, uint8_t *) {
+    return open_port_table::scan(open_ports, src_port, dst_port) != -1;
 }
 
-bool l4_packet::proccess_packet(open_port_vec &open_ports, uint8_t[], uint8_t, memory_dest &dst) {
-    for (auto& port : open_ports) {
-        if (port.src_prt == src_port && port.dst_prt == dst_port) {
-            if (address + data.size() > DATA_ARR_SIZE) return false;
-            for (size_t i = 0; i < data.size(); ++i)
-                port.data[address + i] = data[i];
-            dst = LOCAL_DRAM;
-            return true;
-        }
+bool l4_packet::proccess_packet(open_port_vec &open_ports, uint8_t *, uint8_t, memory_dest &dst) {
+    int idx = open_port_table::scan(open_ports, src_port, dst_port);
+    if (idx == -1) return false; // No matching port found - drop the packet
+
+    return write_dram(open_ports[idx], dst);
+}
+
+bool l4_packet::validate_packet(const nic_context &ctx) const {
+    return ctx.ports.find(src_port, dst_port) != -1;
+}
+
+bool l4_packet::proccess_packet(const nic_context &ctx, open_port_vec &open_ports, memory_dest &dst) {
+    int idx = ctx.ports.find(src_port, dst_port);
+    if (idx == -1) return false; // No matching port found - drop the packet
+
+    return write_dram(open_ports[idx], dst);
+}
+
+bool l4_packet::write_dram(common::open_port &port, memory_dest &dst) const {
+    if (address + data_size() > DATA_ARR_SIZE) return false;
+    if (!data_text.empty()) {
+        decode_canonical_hex(data_text, port.data + address);
+    } else if (!data.empty()) {
+        std::memcpy(port.data + address, data.data(), data.size());
     }
-    return false; // No matching port found - drop the packet
+    dst = LOCAL_DRAM;
+    return true;
+}
+
+uint16_t l4_packet::data_checksum() const {
+    if (!data_text.empty()) return canonical_hex_checksum(data_text);
+    return bytes_checksum(data.data(), data.size());
+}
+
+void l4_packet::decode_data() {
+    if (data_text.empty()) return;
+    data.resize(data_size());
+    decode_canonical_hex(data_text, data.data());
+    data_text = std::string_view();
 }
 
 bool l4_packet::as_string(std::string &packet) {
-    std::ostringstream oss;
-    oss << src_port << "|" << dst_port << "|" << address << "|";
-    for (size_t i = 0; i < data.size(); ++i) {
-        oss << std::nouppercase << std::setw(2) << std::setfill('0') << std::hex << (int)data[i];
-        if (i + 1 < data.size()) oss << " ";
-    }
-    packet = oss.str();
+    packet.resize(string_size());
+    packet.resize(write_string(&packet[0]) - packet.data());
     return true;
+}
+
+size_t l4_packet::string_size() const {
+    return 3 * DEC_U32_MAX_SIZE + 3 + (data_text.empty() ? hex_bytes_size(data.size()) : data_text.size());
+}
+
+char *l4_packet::write_string(char *out) const {
+    out = format_dec(out, src_port);
+    *out++ = '|';
+    out = format_dec(out, dst_port);
+    *out++ = '|';
+    out = format_dec(out, address);
+    *out++ = '|';
+    if (!data_text.empty()) {
+        // Canonical text is exactly what formatting would produce
+        std::memcpy(out, data_text.data(), data_text.size());
+        return out + data_text.size();
+    }
+    return format_hex_bytes(out, data.data(), data.size());
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #pragma once
-#include "packets.hpp"
+#include "nic_packet.hpp"
+#include "packet_parser.hpp"
+#include "payload_buffer.hpp"
 #include <vector>
+#include <memory_resource>
 #include <cstdint>
 #include <string>
 
@@ -8,10 +11,10 @@
  * @class l4_packet
  * @brief Represents a Layer 4 (Transport) packet for the NIC simulation.
  *
- * This class implements the generic_packet interface for L4 packets,
+ * This class implements the nic_packet interface for L4 packets,
  * providing validation, processing, and string conversion functionalities.
  */
-class l4_packet : public generic_packet {
+class l4_packet final : public nic_packet {
 public:
     /**
      * @fn l4_packet
@@ -24,6 +27,18 @@ public:
      */
     l4_packet(uint16_t src_port, uint16_t dst_port, uint32_t address, const std::vector<uint8_t>& data);
 
+    /**
+     * @fn l4_packet
+     * @brief Constructor for L4 packet from explicit fields, taking over the
+     *        data buffer (and the memory resource it allocates from).
+     *
+     * @param [in] src_port - Source port.
+     * @param [in] dst_port - Destination port.
+     * @param [in] address - Address in the data array.
+     * @param [in] data - Packet data bytes.
+     */
+    l4_packet(uint16_t src_port, uint16_t dst_port, uint32_t address, payload_buffer&& data);
+
     /**
      * @fn l4_packet
      * @brief Constructor for L4 packet from a delimited string.
@@ -32,6 +47,20 @@ public:
      */
     l4_packet(const std::string& str);
 
+    /**
+     * @fn l4_packet
+     * @brief Constructor for L4 packet from an already tokenized string.
+     *
+     * @param [in] fields - Tokenized packet string.
+     * @param [in] first  - Index of the first L4 field (source port).
+     * @param [in] mem    - Memory resource for data longer than DATA_ARR_SIZE.
+     * @param [in] keep_text - Keep canonical data as a view of its hex text
+     *                         (see data_text). The string must then outlive
+     *                         the packet.
+     */
+    l4_packet(const packet_fields& fields, size_t first,
+              std::pmr::memory_resource *mem = std::pmr::get_default_resource(), bool keep_text = false);
+
     /**
      * @fn validate_packet
      * @brief Check whether the packet is valid.
@@ -58,6 +87,60 @@ public:
      */
     bool proccess_packet(open_port_vec &open_ports, uint8_t ip[IP_V4_SIZE], uint8_t mask, memory_dest &dst) override;
 
+    /**
+     * @fn validate_packet
+     * @brief Check whether the packet is valid.
+     *
+     * @param [in] ctx - NIC configuration.
+     *
+     * @return true if the packet is valid, false otherwise.
+     */
+    bool validate_packet(const nic_context &ctx) const override;
+
+    /**
+     * @fn proccess_packet
+     * @brief Modify the packet and return the memory location it should be stored in.
+     *
+     * @param [in] ctx            - NIC configuration.
+     * @param [in,out] open_ports - Vector containing all the NIC's open ports.
+     * @param [out] dst           - Reference to enum indicating the memory space.
+     *
+     * @return true on success, false on failure.
+     */
+    bool proccess_packet(const nic_context &ctx, open_port_vec &open_ports, memory_dest &dst) override;
+
+    /**
+     * @fn write_dram
+     * @brief Write the packet's data to its open port's LOCAL DRAM.
+     *
+     * @param [in,out] port - The packet's open port.
+     * @param [out] dst     - Set to LOCAL_DRAM on success.
+     *
+     * @return true on success, false if the data does not fit.
+     */
+    bool write_dram(common::open_port &port, memory_dest &dst) const;
+
+    /**
+     * @fn data_size
+     * @brief Number of data bytes, whether decoded or not.
+     */
+    size_t data_size() const {
+        return data_text.empty() ? data.size() : (data_text.size() + 1) / 3;
+    }
+
+    /**
+     * @fn data_checksum
+     * @brief Byte sum of the data mod 2^16, computed from the hex text while
+     *        the data is not decoded.
+     */
+    uint16_t data_checksum() const;
+
+    /**
+     * @fn decode_data
+     * @brief Decode data_text into data. Needed before reading data directly.
+     */
+    void decode_data();
+
     /**
      * @fn as_string
      * @brief Convert the packet to string.
@@ -68,8 +151,25 @@ public:
      */
     bool as_string(std::string &packet) override;
 
+    /**
+     * @fn string_size
+     * @brief Upper bound on the length of the packet's string representation.
+     */
+    size_t string_size() const override;
+
+    /**
+     * @fn write_string
+     * @brief Write the packet's string representation into a buffer.
+     *
+     * @param [out] out - Output buffer, at least string_size() bytes.
+     *
+     * @return End of the written text.
+     */
+    char *write_string(char *out) const override;
+
     uint16_t src_port;   /**< Source port */
     uint16_t dst_port;   /**< Destination port */
     uint32_t address;    /**< Address in the data array */
-    std::vector<uint8_t> data; /**< Packet data bytes */
+    payload_buffer data;            /**< Packet data bytes, empty while data_text is set */
+    std::string_view data_text;     /**< Canonical hex text of the data while it is not decoded */
 };
\ No newline at end of file
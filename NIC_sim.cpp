@@ -1,88 +1,189 @@
 #include "NIC_sim.hpp"
-#include <fstream>
-#include <sstream>
-#include <regex>
-#include <cctype>
+#include <stdexcept>
 #include <iostream>
-#include <iomanip>
+#include <unistd.h>
 #include <memory>
+#include <deque>
 #include <vector>
 #include <string>
+#include <cstring>
 
-// --- Free function: extract_between_delimiters ---
-static std::string extract_between_delimiters(const std::string& input,
-                                              char delimiter,
-                                              int start_index,
-                                              int end_index = -1)
-{
-    std::vector<size_t> positions;
-    size_t pos = input.find(delimiter);
-    size_t start = 0;
+// Lines per worker in each nic_flow batch
+static const size_t FLOW_BATCH_SIZE = 1024;
 
-    /* Create position vector. */
-    while (pos != std::string::npos) {
-        positions.push_back(pos);
-        pos = input.find(delimiter, pos + 1);
-    }
-
-    /* Check start index. */
-    if (start_index < 0 || start_index > static_cast<int>(positions.size())) {
-        return "";
+/**
+ * @fn prefilter
+ * @brief Check the header fields that drop most packets before the packet
+ *        is built: the L2 destination MAC, a zero TTL and a missing open
+ *        port (for L4 packets, and for L3 packets addressed to the NIC).
+ *
+ *        Each check only rejects packets the full validation would drop
+ *        too, so the set of dropped packets is unchanged. Fields that do
+ *        not parse are left for the constructors to reject.
+ *
+ * @param [in] fields  - Tokenized packet string.
+ * @param [in] layer   - Layer of the packet.
+ * @param [in] ctx     - NIC configuration.
+ * @param [out] reason - Why the packet is dropped, on rejection.
+ *
+ * @return true if the packet has to be built, false if it is dropped.
+ */
+static bool prefilter(const packet_fields &fields, packet_layer layer, const nic_context &ctx, drop_reason &reason) {
+    long long src_port, dst_port;
+    if (layer == LAYER_L4) {
+        if (parse_dec(fields[0], src_port) && parse_dec(fields[1], dst_port) &&
+            ctx.ports.find(static_cast<uint16_t>(src_port), static_cast<uint16_t>(dst_port)) == -1) {
+            reason = DROP_NO_PORT;
+            return false;
+        }
+        return true;
     }
 
-    if (start_index > 0) {
-        if (start_index > static_cast<int>(positions.size())) return ""; // invalid
-        start = positions[start_index - 1] + 1;
+    size_t l3 = 0;
+    if (layer == LAYER_L2) {
+        uint8_t dst_mac[MAC_SIZE];
+        if (parse_mac(fields[1], dst_mac) && pack_mac(dst_mac) != ctx.mac_addr) {
+            reason = DROP_BAD_MAC;
+            return false;
+        }
+        l3 = 2;
     }
 
-    /* Extract everything after start delimiter to end of string. */
-    if (end_index == -1) {
-        return input.substr(start);
+    long long ttl;
+    if (parse_dec(fields[l3 + 2], ttl) && static_cast<uint8_t>(ttl) == 0) {
+        reason = DROP_TTL_EXPIRED;
+        return false;
     }
 
-    /* Validate end_index. */
-    if (end_index < start_index || end_index >= static_cast<int>(positions.size())) {
-        return "";
+    uint8_t dst_ip[IP_V4_SIZE];
+    if (parse_ip(fields[l3 + 1], dst_ip) && pack_ipv4(dst_ip) == ctx.ip_addr &&
+        parse_dec(fields[l3 + 4], src_port) && parse_dec(fields[l3 + 5], dst_port) &&
+        ctx.ports.find(static_cast<uint16_t>(src_port), static_cast<uint16_t>(dst_port)) == -1) {
+        reason = DROP_NO_PORT;
+        return false;
     }
-
-    size_t len = positions[end_index] - start;
-
-    return input.substr(start, len);
+    return true;
 }
-// -------------------------------------------------
 
 /**
  * @fn packet_factory
  * @brief Gets a string representing a packet, creates the corresponding
- *        packet type, and returns a pointer to a generic_packet.
+ *        packet type in the arena, and returns a pointer to a nic_packet.
+ *        Packets failing the prefilter are dropped without being built.
  *
- * @param [in] packet - String representation of a packet.
+ * @param [in] packet  - String representation of a packet.
+ * @param [in] arena   - Arena the packet and its data are allocated from.
+ * @param [out] pkt    - Pointer to the new packet, nullptr on failure.
+ * @param [out] layer  - Layer of the packet.
+ * @param [out] reason - Why the packet was dropped, if it was.
  *
- * @return Pointer to a generic_packet object.
+ * @return PACKET_OK on success, the reason the string was rejected otherwise.
  */
-generic_packet* nic_sim::packet_factory(std::string &packet) {
-    std::string first_field = extract_between_delimiters(packet, '|', 0, 0);
+packet_status nic_sim::packet_factory(std::string_view packet, packet_arena &arena, nic_packet *&pkt,
+                                      packet_layer &layer, drop_reason &reason) const {
+    pkt = nullptr;
+    reason = DROP_PARSE;
+    packet_fields fields(packet);
+    layer = classify_packet(fields[0]);
+    if (layer == LAYER_INVALID) return PACKET_UNKNOWN_LAYER;
+    if (fields.size() != layer_field_count(layer)) return PACKET_BAD_FIELD_COUNT;
+    if (!prefilter(fields, layer, ctx, reason)) return PACKET_FILTERED;
 
-    // Check for MAC address (L2): format XX:XX:XX:XX:XX:XX (hexadecimal)
-    std::regex mac_regex("^[0-9A-Fa-f]{2}(:[0-9A-Fa-f]{2}){5}$");
-    if (std::regex_match(first_field, mac_regex)) {
-        return new l2_packet(packet);
+    try {
+        switch (layer) {
+        // The batch's lines outlive its packets, so data can stay as text
+        case LAYER_L2: pkt = arena.create<l2_packet>(fields, 0, &arena, true); break;
+        case LAYER_L3: pkt = arena.create<l3_packet>(fields, 0, &arena, true); break;
+        default:       pkt = arena.create<l4_packet>(fields, 0, &arena, true); break;
+        }
+    } catch (const std::invalid_argument &) {
+        return PACKET_MALFORMED;
     }
+    return PACKET_OK;
+}
 
-    // Check for IPv4 address (L3): format X.X.X.X (decimal, 0-255)
-    std::regex ip_regex("^([0-9]{1,3}\\.){3}[0-9]{1,3}$");
-    if (std::regex_match(first_field, ip_regex)) {
-        return new l3_packet(packet);
-    }
+/**
+ * @fn parse_port_line
+ * @brief Find "src_prt:<num>, dst_port:<num>" in a parameter file line.
+ *
+ * @param [in] line - Parameter file line.
+ * @param [out] src - Source port.
+ * @param [out] dst - Destination port.
+ *
+ * @return true if the line holds an open port, false otherwise (also for
+ *         a port number that does not fit 16 bits).
+ */
+static bool parse_port_line(std::string_view line, uint16_t &src, uint16_t &dst) {
+    const std::string_view src_key = "src_prt:";
+    const std::string_view dst_key = ", dst_port:";
+    auto digits_at = [&line](size_t at) {
+        size_t end = at;
+        while (end < line.size() && line[end] >= '0' && line[end] <= '9') ++end;
+        return end - at;
+    };
+
+    for (size_t at = line.find(src_key); at != std::string_view::npos; at = line.find(src_key, at + 1)) {
+        size_t src_at = at + src_key.size();
+        size_t src_len = digits_at(src_at);
+        if (src_len == 0 || line.substr(src_at + src_len, dst_key.size()) != dst_key) continue;
+        size_t dst_at = src_at + src_len + dst_key.size();
+        size_t dst_len = digits_at(dst_at);
+        if (dst_len == 0) continue;
 
-    // Otherwise, assume L4 (ports are decimal numbers)
-    bool is_number = !first_field.empty() && std::all_of(first_field.begin(), first_field.end(), ::isdigit);
-    if (is_number) {
-        return new l4_packet(packet);
+        long long src_val, dst_val;
+        if (!parse_dec(line.substr(src_at, src_len), src_val) || src_val > 0xFFFF ||
+            !parse_dec(line.substr(dst_at, dst_len), dst_val) || dst_val > 0xFFFF)
+            return false;
+        src = static_cast<uint16_t>(src_val);
+        dst = static_cast<uint16_t>(dst_val);
+        return true;
     }
+    return false;
+}
+
+/**
+ * @fn parse_route_line
+ * @brief Parse a "route: <a.b.c.d>/<len> <RQ|TQ|DROP>" parameter file line.
+ *
+ * @param [in] line    - Parameter file line.
+ * @param [out] prefix - Prefix address, packed by pack_ipv4.
+ * @param [out] length - Prefix length.
+ * @param [out] action - Action of the prefix.
+ *
+ * @return true if the line holds a route, false otherwise.
+ */
+static bool parse_route_line(std::string_view line, uint32_t &prefix, uint8_t &length, route_action &action) {
+    const std::string_view key = "route:";
+    auto skip_blanks = [&line](size_t at) {
+        while (at < line.size() && (line[at] == ' ' || line[at] == '\t')) ++at;
+        return at;
+    };
+
+    size_t at = skip_blanks(0);
+    if (line.substr(at, key.size()) != key) return false;
+    at = skip_blanks(at + key.size());
+    size_t slash = line.find('/', at);
+    if (slash == std::string_view::npos) return false;
+    size_t len_end = line.find_first_of(" \t", slash);
+    if (len_end == std::string_view::npos) return false;
 
-    // Unknown format
-    return nullptr;
+    uint8_t ip[IP_V4_SIZE];
+    long long len_val;
+    if (!parse_ip(line.substr(at, slash - at), ip) ||
+        !parse_dec(line.substr(slash + 1, len_end - slash - 1), len_val) || len_val < 0 || len_val > 32)
+        return false;
+
+    at = skip_blanks(len_end);
+    size_t word_end = line.find_first_of(" \t\r", at);
+    std::string_view word = line.substr(at, word_end == std::string_view::npos ? word_end : word_end - at);
+    if (word == "RQ") action = ACTION_RQ;
+    else if (word == "TQ") action = ACTION_TQ;
+    else if (word == "DROP") action = ACTION_DROP;
+    else return false;
+
+    prefix = pack_ipv4(ip);
+    length = static_cast<uint8_t>(len_val);
+    return true;
 }
 
 /**
@@ -91,98 +192,477 @@ generic_packet* nic_sim::packet_factory(std::string &packet) {
  *
  * @param [in] param_file - File name containing the NIC's parameters.
  */
-nic_sim::nic_sim(std::string param_file) {
-    std::ifstream fin(param_file);
-    std::string line;
+nic_sim::nic_sim(std::string param_file)
+    : RQ(new memory_sink), TQ(new memory_sink),
+      batches{packet_batch(LAYER_L2), packet_batch(LAYER_L3), packet_batch(LAYER_L4)}, workers(1),
+      flow_cache_size(0) {
+    line_reader fin(param_file);
+    std::string_view line;
 
     // 1. Read MAC address
-    if (std::getline(fin, line)) {
-        std::istringstream iss(line);
-        for (int i = 0; i < MAC_SIZE; ++i) {
-            std::string byte;
-            std::getline(iss, byte, ':');
-            mac[i] = static_cast<uint8_t>(std::stoul(byte, nullptr, 16));
-        }
+    if (fin.next(line)) {
+        uint8_t mac[MAC_SIZE] = {};
+        parse_mac(line, mac);
+        ctx.set_mac(mac);
     }
 
     // 2. Read IP address and mask
-    if (std::getline(fin, line)) {
+    if (fin.next(line)) {
         size_t slash = line.find('/');
-        std::string ip_str = line.substr(0, slash);
-        std::string mask_str = line.substr(slash + 1);
-        std::istringstream iss(ip_str);
-        for (int i = 0; i < IP_V4_SIZE; ++i) {
-            std::string byte;
-            std::getline(iss, byte, '.');
-            ip[i] = static_cast<uint8_t>(std::stoi(byte));
-        }
-        mask = static_cast<uint8_t>(std::stoi(mask_str));
+        uint8_t ip[IP_V4_SIZE] = {};
+        long long mask_val = 0;
+        parse_ip(line.substr(0, slash), ip);
+        if (slash != std::string_view::npos) parse_dec(line.substr(slash + 1), mask_val);
+        ctx.set_address(ip, static_cast<uint8_t>(mask_val));
     }
 
-    // 3. Read open ports
-    while (std::getline(fin, line)) {
-        std::regex port_regex("src_prt:([0-9]+), dst_port:([0-9]+)");
-        std::smatch match;
-        if (std::regex_search(line, match, port_regex)) {
-            uint16_t src = static_cast<uint16_t>(std::stoi(match[1]));
-            uint16_t dst = static_cast<uint16_t>(std::stoi(match[2]));
+    // The NIC's own network is a prefix like any other, so longer routes
+    // inside it and shorter routes around it both take effect
+    ctx.routes.add(ctx.ip_addr & ctx.netmask, ctx.mask, ACTION_NET);
+
+    // 3. Read open ports and routes
+    while (fin.next(line)) {
+        uint16_t src, dst;
+        uint32_t prefix;
+        uint8_t length;
+        route_action action;
+        if (parse_port_line(line, src, dst)) {
             open_ports.emplace_back(dst, src);
+        } else if (parse_route_line(line, prefix, length, action)) {
+            ctx.routes.add(prefix, length, action);
         }
     }
+
+    // 4. Index the open ports for O(1) L4 lookups and expand the routes
+    ctx.ports.build(open_ports);
+    ctx.routes.build();
+    ctx.config_changed();
+}
+
+/**
+ * @fn batch_of
+ * @brief Get the structure-of-arrays batch of a layer.
+ *
+ * @param [in] layer - LAYER_L2, LAYER_L3 or LAYER_L4.
+ */
+packet_batch &nic_sim::batch_of(packet_layer layer) {
+    return batches[layer - LAYER_L2];
+}
+
+/**
+ * @fn set_workers
+ * @brief Set the number of threads nic_flow parses and validates with.
+ *
+ * @param [in] count - Number of worker threads, 0 is treated as 1.
+ */
+void nic_sim::set_workers(unsigned count) {
+    workers = count ? count : 1;
+}
+
+/**
+ * @fn set_queue_sink
+ * @brief Replace the sink packets forwarded to RQ or TQ are stored in.
+ *
+ * @param [in] queue - memory_dest::RQ or memory_dest::TQ.
+ * @param [in] sink  - New sink, the previous one is destroyed.
+ */
+void nic_sim::set_queue_sink(memory_dest queue, std::unique_ptr<queue_sink> sink) {
+    if (!sink) return;
+    if (queue == memory_dest::RQ) RQ = std::move(sink);
+    else if (queue == memory_dest::TQ) TQ = std::move(sink);
+}
+
+/**
+ * @fn set_flow_cache
+ * @brief Enable or disable the per-worker flow decision cache.
+ *
+ * @param [in] entries - Entries per worker, 0 disables the cache.
+ */
+void nic_sim::set_flow_cache(size_t entries) {
+    flow_cache_size = entries;
+    flow_caches.clear();
+}
+
+/**
+ * @fn flow_stats
+ * @brief Flow cache counters summed over all workers.
+ */
+flow_cache_stats nic_sim::flow_stats() const {
+    flow_cache_stats total{0, 0, 0};
+    for (const auto &cache : flow_caches) {
+        flow_cache_stats s = cache.stats();
+        total.hits += s.hits;
+        total.misses += s.misses;
+        total.evictions += s.evictions;
+    }
+    return total;
+}
+
+/**
+ * @fn nic_print_stats
+ * @brief Prints the nic_flow counters as JSON.
+ *
+ * @param [in] out - Output stream.
+ */
+void nic_sim::nic_print_stats(std::ostream &out) const {
+    stats.dump_json(out);
 }
 
 /**
  * @fn nic_flow
  * @brief Process and store to relevant location all packets in packet_file.
  *
+ *        The file is memory mapped (or read in chunks for pipes and "-" for
+ *        stdin) and lines are read in batches without being copied.
+ *        Parsing, validation and routing of a batch are spread over the
+ *        worker pool, then processing (DRAM writes, queue pushes) is applied
+ *        on this thread in input order, so the results are identical for any
+ *        number of workers. Packets are allocated from per-worker arenas that are
+ *        reset after every batch.
+ *
+ *        Binary traces (see packet_binary.hpp) are detected by their header
+ *        and ingested without any text parsing.
+ *
  * @param [in] packet_file - Name of file containing packets as strings.
  */
 void nic_sim::nic_flow(std::string packet_file) {
-    std::ifstream fin(packet_file);
-    std::string line;
-    while (std::getline(fin, line)) {
-        if (line.empty()) continue;
-        std::unique_ptr<generic_packet> pkt(packet_factory(line));
-        if (!pkt) continue;
+    line_reader fin(packet_file);
+    worker_pool pool(workers);
+    std::deque<packet_arena> arenas(pool.size());
+    stats.resize(pool.size());
+    if (flow_cache_size) {
+        while (flow_caches.size() < pool.size()) flow_caches.emplace_back(flow_cache_size);
+        for (auto &cache : flow_caches) cache.sync(ctx.generation);
+    }
+
+    std::string_view header;
+    if (fin.peek(BINARY_HEADER_SIZE, header) && is_binary_header(header)) {
+        fin.read(BINARY_HEADER_SIZE, header);
+        flow_binary(fin, pool, arenas);
+        return;
+    }
+
+    std::vector<std::string_view> lines(FLOW_BATCH_SIZE * pool.size());
+    size_t count = 0;
+    while (fin.next(lines[count])) {
+        if (lines[count].empty()) continue;
+        if (++count == lines.size()) {
+            flow_batch(lines, count, pool, arenas);
+            fin.release();
+            count = 0;
+        }
+    }
+    flow_batch(lines, count, pool, arenas);
+}
+
+/**
+ * @fn flow_binary
+ * @brief Process all records of a binary trace.
+ *
+ *        Records are decoded in batches on this thread, then validated on
+ *        the pool and processed in input order.
+ *
+ * @param [in] fin    - Reader positioned after the trace header.
+ * @param [in] pool   - Worker pool.
+ * @param [in] arenas - One packet arena per worker.
+ */
+void nic_sim::flow_binary(line_reader &fin, worker_pool &pool, std::deque<packet_arena> &arenas) {
+    std::vector<packet_ptr> pkts;
+    std::vector<packet_layer> layers;
+    stats_shard &main = stats.shard(0);
+    bool more = true;
+    while (more) {
+        while (pkts.size() < FLOW_BATCH_SIZE * pool.size()) {
+            nic_packet *raw;
+            packet_layer layer;
+            auto start = stats_shard::start();
+            packet_status status = read_binary_packet(fin, arenas[0], raw, layer);
+            if (status != PACKET_OK || !raw) {
+                // A corrupt record cannot be skipped, stop at it
+                if (status != PACKET_OK) {
+                    main.count_packet();
+                    main.drop(DROP_PARSE);
+                }
+                more = false;
+                break;
+            }
+            main.record(STAGE_PARSE, start);
+            main.count_packet();
+            pkts.emplace_back(raw);
+            layers.push_back(layer);
+        }
+
+        apply_batch(pkts, layers, pool);
+        pkts.clear();
+        layers.clear();
+        arenas[0].reset();
+        fin.release();
+    }
+}
+
+/**
+ * @fn flow_batch
+ * @brief Parse a batch of lines on the pool, then validate and process the
+ *        packets.
+ *
+ * @param [in] lines  - Packet strings.
+ * @param [in] count  - Number of lines in use.
+ * @param [in] pool   - Worker pool.
+ * @param [in] arenas - One packet arena per worker, reset after the batch.
+ */
+void nic_sim::flow_batch(std::vector<std::string_view> &lines, size_t count, worker_pool &pool,
+                         std::deque<packet_arena> &arenas) {
+    std::vector<packet_ptr> pkts(count);
+    std::vector<packet_layer> layers(count, LAYER_INVALID);
+    pool.run(count, [&](size_t begin, size_t end, unsigned worker) {
+        stats_shard &shard = stats.shard(worker);
+        for (size_t i = begin; i < end; ++i) {
+            nic_packet *raw;
+            auto start = stats_shard::start();
+            shard.count_packet();
+            drop_reason reason;
+            if (packet_factory(lines[i], arenas[worker], raw, layers[i], reason) != PACKET_OK) {
+                shard.drop(reason);
+                continue;
+            }
+            shard.record(STAGE_PARSE, start);
+            pkts[i].reset(raw);
+        }
+    });
+    apply_batch(pkts, layers, pool);
+    pkts.clear();
+    for (auto &arena : arenas) arena.reset();
+}
+
+/**
+ * @fn apply_batch
+ * @brief Validate and route a batch of packets, then process them in input
+ *        order.
+ *
+ *        The packets are grouped by layer into structure-of-arrays batches
+ *        that are validated and classified on the pool without any virtual
+ *        calls. Only the packets that survive are touched again, to apply
+ *        their route (forwarding, DRAM writes) and store them: on this
+ *        thread with a single worker, sharded across the pool otherwise.
+ *
+ * @param [in] pkts   - Batch, nullptr entries were rejected by the parser.
+ * @param [in] layers - Layer of each packet.
+ * @param [in] pool   - Worker pool.
+ */
+void nic_sim::apply_batch(std::vector<packet_ptr> &pkts, const std::vector<packet_layer> &layers,
+                          worker_pool &pool) {
+    for (auto &batch : batches) batch.clear();
+    for (size_t i = 0; i < pkts.size(); ++i) {
+        if (pkts[i]) batch_of(layers[i]).add(*pkts[i], static_cast<uint32_t>(i));
+    }
+
+    for (auto &batch : batches) {
+        pool.run(batch.size(), [&](size_t begin, size_t end, unsigned worker) {
+            auto start = stats_shard::start();
+            batch.validate(ctx, begin, end);
+            batch.classify(ctx, begin, end, flow_caches.empty() ? nullptr : &flow_caches[worker]);
+            stats.shard(worker).record(STAGE_VALIDATE, start, end - begin);
+        });
+    }
+
+    if (pool.size() > 1) {
+        apply_sharded(pkts, layers, pool);
+        return;
+    }
+
+    // Each layer's batch holds its packets in input order, so walking the
+    // input with one cursor per batch finds every packet's verdict
+    stats_shard &main = stats.shard(0);
+    size_t next[LAYER_L4] = {};
+    for (size_t i = 0; i < pkts.size(); ++i) {
+        if (!pkts[i]) continue;
+        const packet_batch &batch = batch_of(layers[i]);
+        size_t j = next[layers[i] - LAYER_L2]++;
         memory_dest dst;
-        if (pkt->validate_packet(open_ports, ip, mask, mac)) {
-            if (pkt->proccess_packet(open_ports, ip, mask, dst)) {
-                std::string pkt_str;
-                pkt->as_string(pkt_str);
-                if (dst == memory_dest::RQ) RQ.push_back(pkt_str);
-                else if (dst == memory_dest::TQ) TQ.push_back(pkt_str);
-                // LOCAL_DRAM: already written to open_port struct
+        auto start = stats_shard::start();
+        bool stored = batch.valid[j] && batch.apply(j, *pkts[i], ctx, open_ports, dst);
+        main.record(STAGE_PROCESS, start);
+        if (stored) {
+            // Concrete (final) types, so serializing is statically dispatched
+            switch (layers[i]) {
+            case LAYER_L2: store_packet(static_cast<l2_packet &>(*pkts[i]), dst); break;
+            case LAYER_L3: store_packet(static_cast<l3_packet &>(*pkts[i]), dst); break;
+            default:       store_packet(static_cast<l4_packet &>(*pkts[i]), dst); break;
             }
+        } else {
+            if constexpr (NIC_STATS_ENABLED) main.drop(batch.drop_cause(j, ctx));
         }
     }
 }
 
+/**
+ * @fn append_packet
+ * @brief Serialize a packet of a concrete layer type to the end of text.
+ *
+ * @return Size of the packet's text.
+ */
+template <class Packet>
+static size_t append_packet(const Packet &pkt, std::string &text) {
+    size_t at = text.size();
+    text.resize(at + pkt.string_size());
+    char *end = pkt.write_string(&text[at]);
+    text.resize(end - text.data());
+    return text.size() - at;
+}
+
+/**
+ * @fn apply_sharded
+ * @brief Process a validated batch the way receive-side scaling spreads
+ *        packets over cores.
+ *
+ *        Every packet is hashed on its flow to one queue per worker
+ *        (packet_batch::flow_hash). All packets of an open port land in the
+ *        same queue, so each queue owns a disjoint set of ports and DRAM
+ *        writes need no locking, and a queue is processed in input order,
+ *        so each port sees its writes in the original order. Forwarded
+ *        packets are serialized into their queue; the queues are then
+ *        merged into RQ/TQ by input position, so the results are identical
+ *        to processing the batch on one thread.
+ *
+ * @param [in] pkts   - Batch, nullptr entries were rejected by the parser.
+ * @param [in] layers - Layer of each packet.
+ * @param [in] pool   - Worker pool.
+ */
+void nic_sim::apply_sharded(std::vector<packet_ptr> &pkts, const std::vector<packet_layer> &layers,
+                            worker_pool &pool) {
+    stats_shard &main = stats.shard(0);
+    rss_queues.resize(pool.size());
+    for (auto &queue : rss_queues) {
+        queue.packets.clear();
+        queue.text.clear();
+    }
+    rss_results.assign(pkts.size(), rss_result{RSS_NONE, 0, 0, 0});
+
+    size_t next[LAYER_L4] = {};
+    for (size_t i = 0; i < pkts.size(); ++i) {
+        if (!pkts[i]) continue;
+        const packet_batch &batch = batch_of(layers[i]);
+        size_t j = next[layers[i] - LAYER_L2]++;
+        if (!batch.valid[j]) {
+            if constexpr (NIC_STATS_ENABLED) main.drop(batch.drop_cause(j, ctx));
+            continue;
+        }
+        rss_queue &queue = rss_queues[batch.flow_hash(j) % rss_queues.size()];
+        queue.packets.emplace_back(static_cast<uint32_t>(i), static_cast<uint32_t>(j));
+    }
+
+    pool.run(rss_queues.size(), [&](size_t begin, size_t end, unsigned worker) {
+        stats_shard &shard = stats.shard(worker);
+        for (size_t q = begin; q < end; ++q) {
+            rss_queue &queue = rss_queues[q];
+            for (const auto &entry : queue.packets) {
+                nic_packet &pkt = *pkts[entry.first];
+                const packet_batch &batch = batch_of(layers[entry.first]);
+                memory_dest dst;
+                auto start = stats_shard::start();
+                bool stored = batch.apply(entry.second, pkt, ctx, open_ports, dst);
+                shard.record(STAGE_PROCESS, start);
+                if (!stored) {
+                    if constexpr (NIC_STATS_ENABLED) shard.drop(batch.drop_cause(entry.second, ctx));
+                    continue;
+                }
+                shard.store(dst);
+                if (dst == memory_dest::LOCAL_DRAM) continue;
+
+                start = stats_shard::start();
+                size_t offset = queue.text.size(), size;
+                switch (batch.layer) {
+                case LAYER_L2: size = append_packet(static_cast<l2_packet &>(pkt), queue.text); break;
+                case LAYER_L3: size = append_packet(static_cast<l3_packet &>(pkt), queue.text); break;
+                default:       size = append_packet(static_cast<l4_packet &>(pkt), queue.text); break;
+                }
+                rss_results[entry.first] = rss_result{static_cast<uint8_t>(dst), static_cast<uint32_t>(q),
+                                                      static_cast<uint32_t>(offset), static_cast<uint32_t>(size)};
+                shard.record(STAGE_SERIALIZE, start);
+            }
+        }
+    });
+
+    // Merge the queues in input order
+    for (const auto &result : rss_results) {
+        if (result.dst == RSS_NONE) continue;
+        std::string_view text(rss_queues[result.queue].text.data() + result.offset, result.size);
+        if (result.dst == memory_dest::RQ) RQ->push(text);
+        else if (result.dst == memory_dest::TQ) TQ->push(text);
+    }
+}
+
+/**
+ * @fn store_packet
+ * @brief Store a processed packet to its memory location.
+ *
+ * @param [in] pkt - Processed packet of a concrete layer type.
+ * @param [in] dst - Memory location the packet was routed to.
+ */
+template <class Packet>
+void nic_sim::store_packet(const Packet &pkt, memory_dest dst) {
+    stats_shard &main = stats.shard(0);
+    main.store(dst);
+    // LOCAL_DRAM: already written to open_port struct
+    if (dst == memory_dest::LOCAL_DRAM) return;
+
+    // Serialize into a buffer reused across packets
+    auto start = stats_shard::start();
+    if (store_buf.size() < pkt.string_size()) store_buf.resize(pkt.string_size());
+    std::string_view pkt_str(store_buf.data(), pkt.write_string(&store_buf[0]) - store_buf.data());
+    if (dst == memory_dest::RQ) RQ->push(pkt_str);
+    else if (dst == memory_dest::TQ) TQ->push(pkt_str);
+    main.record(STAGE_SERIALIZE, start);
+}
+
 /**
  * @fn nic_print_results
  * @brief Prints all data stored in memory to stdout in the required format.
  */
 void nic_sim::nic_print_results() {
+    nic_print_results(STDOUT_FILENO);
+}
+
+/**
+ * @fn nic_print_results
+ * @brief Prints all data stored in memory to a file descriptor.
+ *
+ *        The whole dump is formatted into one buffer (DRAM bytes through
+ *        the hex table of packet_format) and written with a few write(2)
+ *        calls instead of a flushed stream line per port and packet.
+ *
+ * @param [in] fd - Open file descriptor, e.g. STDOUT_FILENO.
+ */
+void nic_sim::nic_print_results(int fd) {
+    // Anything already written through std::cout comes first
+    std::cout.flush();
+    fd_writer out(fd);
+
     // LOCAL DRAM
-    std::cout << "LOCAL DRAM:" << std::endl;
+    out.append("LOCAL DRAM:\n");
+    const size_t line_size = 2 * DEC_U32_MAX_SIZE + 3 + hex_bytes_size(DATA_ARR_SIZE) + 1;
     for (const auto& port : open_ports) {
-        std::cout << port.src_prt << " " << port.dst_prt << ": ";
-        for (int i = 0; i < DATA_ARR_SIZE; ++i) {
-            std::cout << std::nouppercase << std::hex << std::setw(2) << std::setfill('0')
-                      << static_cast<int>(port.data[i]);
-            if (i + 1 < DATA_ARR_SIZE) std::cout << " ";
-        }
-        std::cout << std::dec << std::endl;
+        char *p = out.reserve(line_size);
+        p = format_dec(p, port.src_prt);
+        *p++ = ' ';
+        p = format_dec(p, port.dst_prt);
+        *p++ = ':';
+        *p++ = ' ';
+        p = format_hex_bytes(p, port.data, DATA_ARR_SIZE);
+        *p++ = '\n';
+        out.commit(p);
     }
-    std::cout << std::endl; // Blank line after LOCAL DRAM
+    out.append("\n"); // Blank line after LOCAL DRAM
 
     // RQ
-    std::cout << "RQ:" << std::endl;
-    for (const auto& pkt : RQ) std::cout << pkt << std::endl;
-    std::cout << std::endl; // Blank line after RQ
+    out.append("RQ:\n");
+    RQ->print(out);
+    out.append("\n"); // Blank line after RQ
 
     // TQ
-    std::cout << "TQ:" << std::endl;
-    for (const auto& pkt : TQ) std::cout << pkt << std::endl;
+    out.append("TQ:\n");
+    TQ->print(out);
+    out.flush();
 }
 
 /**
@@ -17,6 +17,18 @@
 #include "L2.h"
 #include "L3.h"
 #include "L4.h"
+#include "packet_parser.hpp"
+#include "worker_pool.hpp"
+#include "line_reader.hpp"
+#include "queue_sink.hpp"
+#include "packet_binary.hpp"
+#include "packet_batch.hpp"
+#include "packet_format.hpp"
+#include "fd_writer.hpp"
+#include "flow_cache.hpp"
+#include "nic_stats.hpp"
+#include <memory>
+#include <deque>
 
 class nic_sim {
     public:
@@ -34,12 +46,71 @@ class nic_sim {
      * @fn nic_flow
      * @brief Process and store to relevant location all packets in packet_file.
      *
-     * @param packet_file - Name of file containing packets as strings.
+     * @param packet_file - Name of file containing packets as strings, or "-"
+     *                      for stdin.
      *
      * @return None.
      */
     void nic_flow(std::string packet_file);
 
+    /**
+     * @fn set_workers
+     * @brief Set the number of threads nic_flow parses and validates with.
+     *        Results do not depend on this number.
+     *
+     * @param count - Number of worker threads (default 1).
+     *
+     * @return None.
+     */
+    void set_workers(unsigned count);
+
+    /**
+     * @fn set_queue_sink
+     * @brief Replace the sink packets forwarded to RQ or TQ are stored in.
+     *        By default both queues keep every packet in memory; a
+     *        stream_sink or ring_sink writes them out as they are produced
+     *        and nic_print_results then prints only what is still held. A
+     *        ring_sink without a stream keeps only the last packets.
+     *
+     * @param queue - memory_dest::RQ or memory_dest::TQ.
+     * @param sink - New sink for the queue.
+     *
+     * @return None.
+     */
+    void set_queue_sink(memory_dest queue, std::unique_ptr<queue_sink> sink);
+
+    /**
+     * @fn set_flow_cache
+     * @brief Enable the per-flow decision cache: every worker memoizes the
+     *        routing verdict and open port of recent L3 flows in a cache of
+     *        this many entries. Results do not depend on it.
+     *
+     * @param entries - Entries per worker, 0 disables the cache (default).
+     *
+     * @return None.
+     */
+    void set_flow_cache(size_t entries);
+
+    /**
+     * @fn flow_stats
+     * @brief Flow cache counters summed over all workers.
+     *
+     * @return Hits, misses and evictions since the cache was enabled.
+     */
+    flow_cache_stats flow_stats() const;
+
+    /**
+     * @fn nic_print_stats
+     * @brief Prints the packet counters, drop reasons and per-stage latency
+     *        histograms of all nic_flow calls as JSON. Only collected when
+     *        compiled with NIC_STATS (make STATS=1).
+     *
+     * @param out - Output stream.
+     *
+     * @return None.
+     */
+    void nic_print_stats(std::ostream &out) const;
+
     /**
      * @fn nic_print_results
      * @brief Prints all data stored in memory to stdout in the following format:
@@ -59,6 +130,17 @@ class nic_sim {
      */
     void nic_print_results();
 
+    /**
+     * @fn nic_print_results
+     * @brief Prints all data stored in memory, in the same format, to a file
+     *        descriptor. Output is buffered and written in large blocks.
+     *
+     * @param fd - Open file descriptor (not closed).
+     *
+     * @return None.
+     */
+    void nic_print_results(int fd);
+
     /**
      * @fn ~nic_sim
      * @brief Destructor of the class.
@@ -71,31 +153,141 @@ class nic_sim {
     /**
      * @fn packet_factory
      * @brief Gets a string representing a packet, creates the corresponding
-     *        packet type, and returns a pointer to a generic_packet.
+     *        packet type in the arena, and returns a pointer to a nic_packet.
      *
      * @param packet - String representation of a packet.
+     * @param arena - Arena the packet and its data are allocated from.
+     * @param pkt - Pointer to the new packet, nullptr on failure.
+     * @param layer - Layer of the packet.
+     * @param reason - Why the packet was dropped, if it was.
      *
-     * @return Pointer to a generic_packet object.
+     * @return PACKET_OK on success, the reason the string was rejected otherwise.
      */
-    generic_packet *packet_factory(std::string &packet);
+    packet_status packet_factory(std::string_view packet, packet_arena &arena, nic_packet *&pkt,
+                                 packet_layer &layer, drop_reason &reason) const;
+
+    /**
+     * @fn flow_batch
+     * @brief Parse a batch of lines on the pool, then validate and process
+     *        the packets.
+     *
+     * @param lines - Packet strings.
+     * @param count - Number of lines in use.
+     * @param pool - Worker pool.
+     * @param arenas - One packet arena per worker, reset after the batch.
+     *
+     * @return None.
+     */
+    void flow_batch(std::vector<std::string_view> &lines, size_t count, worker_pool &pool,
+                    std::deque<packet_arena> &arenas);
+
+    /**
+     * @fn flow_binary
+     * @brief Process all records of a binary trace.
+     *
+     * @param fin - Reader positioned after the trace header.
+     * @param pool - Worker pool.
+     * @param arenas - One packet arena per worker.
+     *
+     * @return None.
+     */
+    void flow_binary(line_reader &fin, worker_pool &pool, std::deque<packet_arena> &arenas);
+
+    /**
+     * @fn apply_batch
+     * @brief Validate and route a batch of packets as structure-of-arrays
+     *        batches on the pool, then process them in input order.
+     *
+     * @param pkts - Batch, nullptr entries were rejected by the parser.
+     * @param layers - Layer of each packet.
+     * @param pool - Worker pool.
+     *
+     * @return None.
+     */
+    void apply_batch(std::vector<packet_ptr> &pkts, const std::vector<packet_layer> &layers,
+                     worker_pool &pool);
+
+    /**
+     * @fn apply_sharded
+     * @brief Process the packets of a validated batch on the pool, sharded
+     *        by flow (see apply_batch).
+     *
+     * @param pkts - Batch, nullptr entries were rejected by the parser.
+     * @param layers - Layer of each packet.
+     * @param pool - Worker pool.
+     *
+     * @return None.
+     */
+    void apply_sharded(std::vector<packet_ptr> &pkts, const std::vector<packet_layer> &layers,
+                       worker_pool &pool);
+
+    /**
+     * @fn store_packet
+     * @brief Store a processed packet to its memory location.
+     *
+     * @param pkt - Processed packet of a concrete layer type.
+     * @param dst - Memory location the packet was routed to.
+     *
+     * @return None.
+     */
+    template <class Packet>
+    void store_packet(const Packet &pkt, memory_dest dst);
+
+    /**
+     * @fn batch_of
+     * @brief Get the structure-of-arrays batch of a layer.
+     *
+     * @param layer - LAYER_L2, LAYER_L3 or LAYER_L4.
+     *
+     * @return The layer's batch.
+     */
+    packet_batch &batch_of(packet_layer layer);
 
     /**
      * @param open_ports - Vector containing all open communications.
-     * @param RQ - Vector of strings to store packets that sent to RQ.
-     * @param TQ - Vector of strings to store packets that sent to TQ.
+     * @param RQ - Sink storing packets that sent to RQ.
+     * @param TQ - Sink storing packets that sent to TQ.
      */
     common::open_port_vec open_ports;
-    std::vector<std::string> RQ;
-    std::vector<std::string> TQ;
+    std::unique_ptr<queue_sink> RQ;
+    std::unique_ptr<queue_sink> TQ;
 
     /**
      * @note It is recommended and even encouraged to add new functions or
      *       additional parameters to the object, but the existing functionality
      *       must be implemented.
      */
-    uint8_t mac[MAC_SIZE];
-    uint8_t ip[IP_V4_SIZE];
-    uint8_t mask;
+    nic_context ctx;    /**< NIC's MAC, IP, mask and open port index */
+    std::vector<packet_batch> batches; /**< Per-layer batches, reused by nic_flow */
+    std::string store_buf;  /**< Serialization buffer of store_packet */
+    unsigned workers;   /**< Number of nic_flow worker threads */
+    size_t flow_cache_size;                 /**< Flow cache entries per worker */
+    std::vector<flow_cache> flow_caches;    /**< One flow cache per worker */
+    nic_stats stats;    /**< Per-thread counters, shard 0 for this thread */
+
+    /**
+     * @struct rss_queue
+     * @brief Packets of one flow shard and the text of those it forwards.
+     */
+    struct rss_queue {
+        std::vector<std::pair<uint32_t, uint32_t>> packets; /**< (input position, batch index) */
+        std::string text;                                   /**< Serialized RQ/TQ packets */
+    };
+
+    /**
+     * @struct rss_result
+     * @brief Where the packet at an input position was stored.
+     */
+    struct rss_result {
+        uint8_t dst;        /**< memory_dest, or RSS_NONE */
+        uint32_t queue;     /**< rss_queue holding the text */
+        uint32_t offset;    /**< Text offset in the queue */
+        uint32_t size;      /**< Text size */
+    };
+    static constexpr uint8_t RSS_NONE = 0xFF; /**< Not stored in RQ/TQ */
+
+    std::vector<rss_queue> rss_queues;      /**< One queue per worker */
+    std::vector<rss_result> rss_results;    /**< One entry per batch position */
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,360 @@
+/**
+ * @file bench.cpp
+ * @brief Throughput benchmarks of the simulator stages on a synthetic trace
+ *        (see trace_gen.hpp).
+ *
+ * Usage: bench.exe [--packets N] [--seed N] [--mix L2:L3:L4]
+ *                  [--payload MIN:MAX] [--ports N] [--flows N]
+ *                  [--locality P] [--drop P] [--workers N] [--rounds N]
+ *
+ * Every stage runs --rounds times and the fastest round is reported as
+ * ns/packet and packets/sec, so runs on the same machine are comparable.
+ * The "ports N" stages rerun validate+proccess on traces with 1 to 4096
+ * open ports, through the context and through the generic_packet
+ * overloads.
+ * The "checksum <kernel> N" stages time each bytes_checksum kernel on N
+ * byte inputs (ns/packet is per call).
+ */
+
+#include "NIC_sim.hpp"
+#include "trace_gen.hpp"
+#include "checksum.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+typedef std::chrono::steady_clock bench_clock;
+
+static unsigned rounds = 5;
+static volatile uint64_t sink; /**< Keeps results of pure stages alive */
+
+/**
+ * @fn report
+ * @brief Print one result line.
+ */
+static void report(const char *stage, size_t packets, double seconds) {
+    double ns = packets ? seconds * 1e9 / packets : 0;
+    double pps = seconds > 0 ? packets / seconds : 0;
+    std::cout << std::left << std::setw(24) << stage << std::right << std::setw(10) << packets
+              << std::fixed << std::setprecision(1) << std::setw(12) << ns
+              << std::setprecision(0) << std::setw(14) << pps << std::endl;
+}
+
+/**
+ * @fn measure
+ * @brief Run a stage rounds times and report its fastest round.
+ *
+ * @param [in] stage   - Stage name.
+ * @param [in] packets - Packets one round handles.
+ * @param [in] setup   - Untimed preparation of each round, may be empty.
+ * @param [in] run     - Timed body.
+ */
+static void measure(const char *stage, size_t packets, const std::function<void()> &setup,
+                    const std::function<void()> &run) {
+    double best = 0;
+    for (unsigned r = 0; r < rounds; ++r) {
+        if (setup) setup();
+        auto start = bench_clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+        if (r == 0 || seconds < best) best = seconds;
+    }
+    report(stage, packets, best);
+}
+
+/**
+ * @fn regex_classify
+ * @brief The classifier packet_factory used before classify_packet:
+ *        two std::regex objects built and matched per line. Kept as the
+ *        baseline of the "tokenize+classify" stage.
+ */
+static packet_layer regex_classify(std::string_view first_field) {
+    std::regex mac_regex("^[0-9A-Fa-f]{2}(:[0-9A-Fa-f]{2}){5}$");
+    if (std::regex_match(first_field.begin(), first_field.end(), mac_regex)) return LAYER_L2;
+
+    std::regex ip_regex("^([0-9]{1,3}\\.){3}[0-9]{1,3}$");
+    if (std::regex_match(first_field.begin(), first_field.end(), ip_regex)) return LAYER_L3;
+
+    bool is_number = !first_field.empty() &&
+                     std::all_of(first_field.begin(), first_field.end(), [](char c) { return c >= '0' && c <= '9'; });
+    return is_number ? LAYER_L4 : LAYER_INVALID;
+}
+
+/**
+ * @fn make_packet
+ * @brief Build a packet line in the arena, the way nic_sim::packet_factory does.
+ */
+static nic_packet *make_packet(std::string_view line, packet_arena &arena, packet_layer &layer) {
+    packet_fields fields(line);
+    layer = classify_packet(fields[0]);
+    if (layer == LAYER_INVALID || fields.size() != layer_field_count(layer)) return nullptr;
+    try {
+        switch (layer) {
+        case LAYER_L2: return arena.create<l2_packet>(fields, 0, &arena);
+        case LAYER_L3: return arena.create<l3_packet>(fields, 0, &arena);
+        default:       return arena.create<l4_packet>(fields, 0, &arena);
+        }
+    } catch (const std::invalid_argument &) {
+        return nullptr;
+    }
+}
+
+static bool parse_pair(const char *arg, size_t &a, size_t &b) {
+    char *end;
+    a = std::strtoul(arg, &end, 10);
+    if (*end != ':') return false;
+    b = std::strtoul(end + 1, &end, 10);
+    return *end == '\0';
+}
+
+static bool parse_args(int argc, char **argv, trace_config &config, unsigned &workers) {
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 >= argc) return false;
+        std::string key = argv[i];
+        const char *val = argv[i + 1];
+        size_t a, b;
+        if (key == "--packets") config.packets = std::strtoul(val, nullptr, 10);
+        else if (key == "--seed") config.seed = std::strtoull(val, nullptr, 10);
+        else if (key == "--ports") config.open_ports = std::strtoul(val, nullptr, 10);
+        else if (key == "--flows") config.flows = std::strtoul(val, nullptr, 10);
+        else if (key == "--locality") config.locality = std::atof(val);
+        else if (key == "--drop") config.drop_ratio = std::atof(val);
+        else if (key == "--workers") workers = std::strtoul(val, nullptr, 10);
+        else if (key == "--rounds") rounds = std::max<unsigned>(std::strtoul(val, nullptr, 10), 1);
+        else if (key == "--payload" && parse_pair(val, a, b)) {
+            config.min_payload = a;
+            config.max_payload = b;
+        } else if (key == "--mix") {
+            char *end;
+            config.l2_weight = std::strtoul(val, &end, 10);
+            if (*end != ':') return false;
+            config.l3_weight = std::strtoul(end + 1, &end, 10);
+            if (*end != ':') return false;
+            config.l4_weight = std::strtoul(end + 1, &end, 10);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    trace_config config;
+    unsigned workers = 1;
+    if (!parse_args(argc, argv, config, workers)) {
+        std::cerr << "Usage: " << argv[0] << " [--packets N] [--seed N] [--mix L2:L3:L4] [--payload MIN:MAX]"
+                  << " [--ports N] [--flows N] [--locality P] [--drop P] [--workers N] [--rounds N]" << std::endl;
+        return 1;
+    }
+
+    trace_generator gen(config);
+    std::vector<std::string> lines = gen.packets();
+    nic_context ctx;
+    common::open_port_vec open_ports;
+    gen.configure(ctx, open_ports);
+
+    // Lines split by layer for the per-layer constructor benchmarks
+    std::vector<std::string_view> by_layer[LAYER_L4 + 1];
+    for (const auto &line : lines) by_layer[classify_packet(packet_fields(line)[0])].push_back(line);
+
+    std::cout << std::left << std::setw(24) << "stage" << std::right << std::setw(10) << "packets"
+              << std::setw(12) << "ns/packet" << std::setw(14) << "packets/sec" << std::endl;
+
+    packet_arena arena;
+    // The regex baseline is ~1000x slower, so it runs on a prefix of the trace
+    const size_t regex_lines = std::min<size_t>(lines.size(), 10000);
+    measure("tokenize+classify regex", regex_lines, nullptr, [&] {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < regex_lines; ++i) {
+            packet_fields fields(lines[i]);
+            sum += regex_classify(fields[0]) + fields.size();
+        }
+        sink = sum;
+    });
+
+    measure("tokenize+classify", lines.size(), nullptr, [&] {
+        uint64_t sum = 0;
+        for (const auto &line : lines) {
+            packet_fields fields(line);
+            sum += classify_packet(fields[0]) + fields.size();
+        }
+        sink = sum;
+    });
+
+    measure("factory", lines.size(), [&] { arena.reset(); }, [&] {
+        packet_layer layer;
+        for (const auto &line : lines) make_packet(line, arena, layer);
+    });
+
+    const char *ctor_names[] = {"", "ctor l2", "ctor l3", "ctor l4"};
+    for (int layer = LAYER_L2; layer <= LAYER_L4; ++layer) {
+        const auto &subset = by_layer[layer];
+        measure(ctor_names[layer], subset.size(), [&] { arena.reset(); }, [&] {
+            for (const auto &line : subset) {
+                packet_fields fields(line);
+                switch (layer) {
+                case LAYER_L2: arena.create<l2_packet>(fields, 0, &arena); break;
+                case LAYER_L3: arena.create<l3_packet>(fields, 0, &arena); break;
+                default:       arena.create<l4_packet>(fields, 0, &arena); break;
+                }
+            }
+        });
+    }
+
+    // Stages working on parsed packets; the arena is refilled untimed
+    std::vector<nic_packet *> pkts;
+    std::vector<packet_layer> layers;
+    auto parse_all = [&] {
+        arena.reset();
+        pkts.clear();
+        layers.clear();
+        for (const auto &line : lines) {
+            packet_layer layer;
+            nic_packet *pkt = make_packet(line, arena, layer);
+            if (!pkt) continue;
+            pkts.push_back(pkt);
+            layers.push_back(layer);
+        }
+    };
+    parse_all();
+    size_t l2_count = std::count(layers.begin(), layers.end(), LAYER_L2);
+    size_t l3_count = std::count(layers.begin(), layers.end(), LAYER_L3);
+
+    measure("checksum l2", l2_count, nullptr, [&] {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < pkts.size(); ++i)
+            if (layers[i] == LAYER_L2) sum += l2_packet::calc_checksum(*static_cast<l2_packet *>(pkts[i]));
+        sink = sum;
+    });
+    measure("checksum l3", l3_count, nullptr, [&] {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < pkts.size(); ++i)
+            if (layers[i] == LAYER_L3) sum += l3_packet::calc_checksum(*static_cast<l3_packet *>(pkts[i]));
+        sink = sum;
+    });
+
+    // Each bytes_checksum kernel the CPU supports, on data of typical sizes;
+    // every call sums a different window of the buffer
+    {
+        std::vector<uint8_t> bytes(1 << 16);
+        for (size_t i = 0; i < bytes.size(); ++i) bytes[i] = static_cast<uint8_t>(i * 131 + 7);
+        for (size_t size : {16, 64, 256, 1500}) {
+            size_t calls = (static_cast<size_t>(1) << 24) / size;
+            size_t windows = bytes.size() - size;
+            for (const auto &kernel : checksum_kernels()) {
+                std::string name = std::string("checksum ") + kernel.name + " " + std::to_string(size);
+                measure(name.c_str(), calls, nullptr, [&] {
+                    uint64_t sum = 0;
+                    for (size_t i = 0; i < calls; ++i) sum += kernel.run(bytes.data() + (i * 64) % windows, size);
+                    sink = sum;
+                });
+            }
+        }
+    }
+
+    measure("validate+proccess", pkts.size(), parse_all, [&] {
+        uint64_t stored = 0;
+        for (auto *pkt : pkts) {
+            memory_dest dst;
+            stored += pkt->validate_packet(ctx) && pkt->proccess_packet(ctx, open_ports, dst);
+        }
+        sink = stored;
+    });
+
+    // Per-packet cost against the number of open ports: flat through the
+    // context's port index, linear through the generic_packet overloads
+    {
+        trace_config sweep_config = config;
+        sweep_config.packets = std::min<size_t>(config.packets, 20000);
+        packet_arena sweep_arena;
+        std::vector<nic_packet *> sweep_pkts;
+        for (size_t ports : {1, 16, 256, 4096}) {
+            sweep_config.open_ports = ports;
+            trace_generator sweep_gen(sweep_config);
+            std::vector<std::string> sweep_lines = sweep_gen.packets();
+            nic_context sweep_ctx;
+            common::open_port_vec sweep_ports;
+            sweep_gen.configure(sweep_ctx, sweep_ports);
+            auto parse_sweep = [&] {
+                sweep_arena.reset();
+                sweep_pkts.clear();
+                for (const auto &line : sweep_lines) {
+                    packet_layer layer;
+                    if (nic_packet *pkt = make_packet(line, sweep_arena, layer)) sweep_pkts.push_back(pkt);
+                }
+            };
+            parse_sweep();
+
+            std::string name = "ports " + std::to_string(ports) + " context";
+            measure(name.c_str(), sweep_pkts.size(), parse_sweep, [&] {
+                uint64_t stored = 0;
+                for (auto *pkt : sweep_pkts) {
+                    memory_dest dst;
+                    stored += pkt->validate_packet(sweep_ctx) && pkt->proccess_packet(sweep_ctx, sweep_ports, dst);
+                }
+                sink = stored;
+            });
+            name = "ports " + std::to_string(ports) + " legacy";
+            measure(name.c_str(), sweep_pkts.size(), parse_sweep, [&] {
+                uint64_t stored = 0;
+                for (auto *pkt : sweep_pkts) {
+                    memory_dest dst;
+                    stored += pkt->validate_packet(sweep_ports, sweep_ctx.ip, sweep_ctx.mask, sweep_ctx.mac) &&
+                              pkt->proccess_packet(sweep_ports, sweep_ctx.ip, sweep_ctx.mask, dst);
+                }
+                sink = stored;
+            });
+        }
+    }
+
+    std::string str;
+    measure("as_string", pkts.size(), parse_all, [&] {
+        uint64_t size = 0;
+        for (auto *pkt : pkts) {
+            pkt->as_string(str);
+            size += str.size();
+        }
+        sink = size;
+    });
+    measure("write_string", pkts.size(), parse_all, [&] {
+        uint64_t size = 0;
+        for (auto *pkt : pkts) {
+            if (str.size() < pkt->string_size()) str.resize(pkt->string_size());
+            size += pkt->write_string(&str[0]) - str.data();
+        }
+        sink = size;
+    });
+
+    arena.reset();
+
+    // End to end through files, as nic_sim.exe runs
+    const char *param_file = "bench_params.txt";
+    const char *packet_file = "bench_packets.txt";
+    {
+        std::ofstream(param_file) << gen.params();
+        std::ofstream out(packet_file);
+        for (const auto &line : lines) out << line << '\n';
+    }
+    int null_fd = open("/dev/null", O_WRONLY);
+    std::unique_ptr<nic_sim> sim;
+    measure("nic_flow", lines.size(), [&] {
+        sim.reset(new nic_sim(param_file));
+        sim->set_workers(workers);
+    }, [&] { sim->nic_flow(packet_file); });
+    measure("nic_print_results", lines.size(), nullptr, [&] { sim->nic_print_results(null_fd); });
+
+    close(null_fd);
+    std::remove(param_file);
+    std::remove(packet_file);
+    return 0;
+}
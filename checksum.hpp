@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @fn bytes_checksum
+ * @brief Sum a byte range mod 2^16, the way the packet checksums add up
+ *        their data bytes.
+ *
+ *        Uses an AVX2 or SSE2 kernel when the CPU supports it (chosen once
+ *        at runtime) and a scalar loop otherwise. All kernels return the
+ *        same result.
+ *
+ * @param [in] data - Bytes to sum.
+ * @param [in] size - Number of bytes.
+ *
+ * @return The byte sum truncated to 16 bits.
+ */
+uint16_t bytes_checksum(const uint8_t *data, size_t size);
+
+/**
+ * @fn bytes_checksum_scalar
+ * @brief Portable reference kernel for bytes_checksum.
+ */
+uint16_t bytes_checksum_scalar(const uint8_t *data, size_t size);
+
+typedef uint16_t (*checksum_kernel)(const uint8_t *, size_t);
+
+/**
+ * @struct named_checksum_kernel
+ * @brief A bytes_checksum kernel and its name.
+ */
+struct named_checksum_kernel {
+    const char *name;     /**< "scalar", "sse2" or "avx2" */
+    checksum_kernel run;  /**< Same contract as bytes_checksum */
+};
+
+/**
+ * @fn checksum_kernels
+ * @brief The bytes_checksum kernels the running CPU supports, narrowest
+ *        first. bytes_checksum uses the last one.
+ */
+std::vector<named_checksum_kernel> checksum_kernels();
+
+/**
+ * Byte sums of packed fields (ports, IPs packed by pack_ipv4, MACs packed
+ * by pack_mac), as the checksums add them up.
+ */
+inline uint32_t sum_u16(uint16_t v) {
+    return (v >> 8) + (v & 0xFF);
+}
+
+inline uint32_t sum_u32(uint32_t v) {
+    return (v & 0xFF) + ((v >> 8) & 0xFF) + ((v >> 16) & 0xFF) + (v >> 24);
+}
+
+inline uint32_t sum_u48(uint64_t v) {
+    return sum_u32(static_cast<uint32_t>(v)) + ((v >> 32) & 0xFF) + ((v >> 40) & 0xFF);
+}
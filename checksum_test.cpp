@@ -0,0 +1,161 @@
+/**
+ * @file checksum_test.cpp
+ * @brief Randomized check of the incremental L3 checksum update.
+ *
+ * Usage: checksum_test.exe [packets] [seed]
+ *
+ * Builds random L3 packets with valid checksums and forwards them through
+ * l3_packet::proccess_packet, which decrements the TTL (and rewrites the
+ * source address of outgoing packets) and adjusts the checksum from the
+ * changed fields. Every forwarded packet must then carry exactly the
+ * checksum calc_checksum computes from scratch. Checksums are biased
+ * towards 0x0000/0xFFFF so the update wraps in both directions, and TTL=1
+ * packets must be dropped.
+ */
+
+#include "L3.h"
+#include "nic_context.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/**
+ * @fn to_bytes
+ * @brief Split an IPv4 address held in an integer into its bytes, first
+ *        byte most significant.
+ */
+static void to_bytes(uint32_t addr, uint8_t ip[IP_V4_SIZE]) {
+    for (int i = IP_V4_SIZE - 1; i >= 0; --i, addr >>= 8) ip[i] = static_cast<uint8_t>(addr);
+}
+
+/**
+ * @fn byte_sum
+ * @brief Sum of the bytes of an IPv4 address, as the checksum adds them.
+ */
+static uint32_t byte_sum(uint32_t addr) {
+    return (addr & 0xFF) + ((addr >> 8) & 0xFF) + ((addr >> 16) & 0xFF) + (addr >> 24);
+}
+
+/**
+ * @fn make_packet
+ * @brief Build an L3 packet whose full checksum equals a target value.
+ *
+ *        The data is random, then padded with bytes that add up to the
+ *        missing difference.
+ *
+ * @param [in] rng    - Random source.
+ * @param [in] src_ip - Source address.
+ * @param [in] dst_ip - Destination address.
+ * @param [in] ttl    - Time To Live.
+ * @param [in] target - Checksum the packet must have.
+ *
+ * @return The packet, with its checksum field set.
+ */
+static l3_packet make_packet(std::mt19937_64 &rng, uint32_t src_ip, uint32_t dst_ip, uint8_t ttl, uint16_t target) {
+    uint8_t src[IP_V4_SIZE], dst[IP_V4_SIZE];
+    to_bytes(src_ip, src);
+    to_bytes(dst_ip, dst);
+    std::vector<uint8_t> data(rng() % (DATA_ARR_SIZE + 1));
+    for (auto &byte : data) byte = static_cast<uint8_t>(rng());
+    l4_packet payload(static_cast<uint16_t>(rng()), static_cast<uint16_t>(rng()), rng() % DATA_ARR_SIZE, data);
+
+    l3_packet pkt(src, dst, ttl, 0, payload);
+    for (uint32_t diff = static_cast<uint16_t>(target - l3_packet::calc_checksum(pkt)); diff; ) {
+        uint8_t byte = static_cast<uint8_t>(std::min<uint32_t>(diff, 0xFF));
+        data.push_back(byte);
+        diff -= byte;
+    }
+    l3_packet padded(src, dst, ttl, 0, l4_packet(payload.src_port, payload.dst_port, payload.address, data));
+    padded.checksum = l3_packet::calc_checksum(padded);
+    return padded;
+}
+
+/**
+ * @fn address
+ * @brief Random address inside or outside a network, never the NIC's own
+ *        address.
+ *
+ * @param [in] rng     - Random source.
+ * @param [in] nic_ip  - NIC's address.
+ * @param [in] netmask - Netmask of the NIC's network.
+ * @param [in] inside  - Whether the address is in the NIC's network.
+ */
+static uint32_t address(std::mt19937_64 &rng, uint32_t nic_ip, uint32_t netmask, bool inside) {
+    for (;;) {
+        uint32_t addr = static_cast<uint32_t>(rng());
+        if (inside) addr = (nic_ip & netmask) | (addr & ~netmask);
+        bool in = ((addr ^ nic_ip) & netmask) == 0;
+        if (in == inside && addr != nic_ip) return addr;
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t packets = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+    std::mt19937_64 rng(seed);
+
+    const uint16_t boundary[] = {0x0000, 0x0001, 0xFFFE, 0xFFFF};
+    size_t forwarded = 0, wrapped_up = 0, wrapped_down = 0, ttl_drops = 0, failures = 0;
+    common::open_port_vec open_ports;
+    for (size_t i = 0; i < packets; ++i) {
+        uint32_t nic_ip = static_cast<uint32_t>(rng());
+        uint8_t mask = static_cast<uint8_t>(8 + rng() % 23);
+        uint32_t netmask = 0xFFFFFFFFu << (32 - mask);
+        uint8_t ip[IP_V4_SIZE];
+        to_bytes(nic_ip, ip);
+        nic_context ctx(ip, mask, nullptr);
+
+        // Incoming, outgoing or transit
+        bool src_in = false, dst_in = false;
+        switch (rng() % 3) {
+        case 0: dst_in = true; break;
+        case 1: src_in = true; break;
+        default: break;
+        }
+        uint32_t src_ip = address(rng, nic_ip, netmask, src_in);
+        uint32_t dst_ip = address(rng, nic_ip, netmask, dst_in);
+        uint8_t ttl = (rng() % 8 == 0) ? 1 : static_cast<uint8_t>(1 + rng() % 255);
+        uint16_t target = (rng() % 2) ? boundary[rng() % 4] : static_cast<uint16_t>(rng());
+        l3_packet pkt = make_packet(rng, src_ip, dst_ip, ttl, target);
+
+        memory_dest dst;
+        bool kept = pkt.proccess_packet(ctx, open_ports, dst);
+        if (ttl == 1) {
+            if (kept) {
+                std::cerr << "packet " << i << ": TTL=1 packet was forwarded" << std::endl;
+                ++failures;
+            }
+            ++ttl_drops;
+            continue;
+        }
+        if (!kept || dst != (dst_in ? RQ : TQ)) {
+            std::cerr << "packet " << i << ": not forwarded to " << (dst_in ? "RQ" : "TQ") << std::endl;
+            ++failures;
+            continue;
+        }
+
+        uint16_t expected = l3_packet::calc_checksum(pkt);
+        if (pkt.checksum != expected) {
+            std::cerr << "packet " << i << ": checksum " << std::hex << pkt.checksum << ", full recompute "
+                      << expected << std::dec << std::endl;
+            ++failures;
+        }
+        // Outgoing packets leave with the NIC's address as their source
+        uint32_t new_src_ip = src_in ? nic_ip : src_ip;
+        long long unwrapped = static_cast<long long>(target) - byte_sum(src_ip) - ttl + byte_sum(new_src_ip) + pkt.ttl;
+        if (unwrapped < 0) ++wrapped_down;
+        if (unwrapped > 0xFFFF) ++wrapped_up;
+        ++forwarded;
+    }
+
+    std::cout << "checksum_test: " << forwarded << " forwarded (" << wrapped_down << " wrapped below 0x0000, "
+              << wrapped_up << " above 0xFFFF), " << ttl_drops << " TTL=1 drops, " << failures << " failures"
+              << std::endl;
+    if (packets && (!wrapped_down || !wrapped_up || !ttl_drops)) {
+        std::cerr << "checksum_test: boundary cases not covered, raise the packet count" << std::endl;
+        return 1;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,47 @@
+#include "fd_writer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+fd_writer::fd_writer(int fd, size_t capacity) : fd(fd), buf(std::max<size_t>(capacity, 1), '\0'), used(0) {}
+
+fd_writer::~fd_writer() {
+    flush();
+}
+
+void fd_writer::append(std::string_view text) {
+    if (text.size() > buf.size() - used) {
+        flush();
+        if (text.size() > buf.size()) buf.resize(text.size());
+    }
+    std::memcpy(&buf[used], text.data(), text.size());
+    used += text.size();
+}
+
+char *fd_writer::reserve(size_t size) {
+    if (size > buf.size() - used) {
+        flush();
+        if (size > buf.size()) buf.resize(size);
+    }
+    return &buf[used];
+}
+
+void fd_writer::commit(char *end) {
+    used = end - buf.data();
+}
+
+bool fd_writer::flush() {
+    size_t done = 0;
+    while (done < used) {
+        ssize_t n = ::write(fd, buf.data() + done, used - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            used = 0;
+            return false;
+        }
+        done += n;
+    }
+    used = 0;
+    return true;
+}
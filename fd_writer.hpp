@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * @class fd_writer
+ * @brief Buffered writer to a file descriptor.
+ *
+ * Output is collected in one large buffer and handed to write(2) only when
+ * the buffer fills up or on flush(), so dumping many short lines costs a
+ * handful of system calls. The descriptor is not closed by the writer.
+ */
+class fd_writer {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 16; /**< Default buffer size */
+
+    /**
+     * @fn fd_writer
+     * @brief Construct a writer.
+     *
+     * @param [in] fd       - Open file descriptor.
+     * @param [in] capacity - Buffer size in bytes.
+     */
+    explicit fd_writer(int fd, size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @fn ~fd_writer
+     * @brief Flush the remaining output.
+     */
+    ~fd_writer();
+
+    fd_writer(const fd_writer &) = delete;
+    fd_writer &operator=(const fd_writer &) = delete;
+
+    /**
+     * @fn append
+     * @brief Append text to the output.
+     *
+     * @param [in] text - Text to write.
+     */
+    void append(std::string_view text);
+
+    /**
+     * @fn reserve
+     * @brief Make room for size bytes to be written directly into the buffer.
+     *
+     * @param [in] size - Number of bytes the caller may write.
+     *
+     * @return Where to write; pass the end of what was written to commit().
+     */
+    char *reserve(size_t size);
+
+    /**
+     * @fn commit
+     * @brief Keep the bytes written after reserve() up to end.
+     *
+     * @param [in] end - End of the written bytes.
+     */
+    void commit(char *end);
+
+    /**
+     * @fn flush
+     * @brief Write out the buffered output.
+     *
+     * @return true on success, false if write(2) failed.
+     */
+    bool flush();
+
+private:
+    int fd;
+    std::string buf;    /**< Buffer, sized to its capacity */
+    size_t used;        /**< Bytes of buf holding output */
+};
@@ -0,0 +1,54 @@
+#include "flow_cache.hpp"
+
+flow_cache::flow_cache(size_t capacity) : set_mask(0), generation(0), counters{0, 0, 0} {
+    if (capacity == 0) return;
+    size_t sets = 1;
+    while (sets * WAYS < capacity) sets <<= 1;
+    set_mask = sets - 1;
+    entries.resize(sets * WAYS);
+    hands.resize(sets);
+    clear();
+}
+
+void flow_cache::sync(uint64_t generation_) {
+    if (generation_ == generation) return;
+    clear();
+    generation = generation_;
+}
+
+void flow_cache::clear() {
+    for (auto &e : entries) e.used = e.referenced = false;
+    for (auto &hand : hands) hand = 0;
+}
+
+bool flow_cache::find(const flow_key &key, flow_verdict &verdict) {
+    if (entries.empty()) return false;
+    entry *set = &entries[set_of(key)];
+    for (size_t way = 0; way < WAYS; ++way) {
+        if (set[way].used && set[way].key == key) {
+            set[way].referenced = true;
+            verdict = set[way].verdict;
+            ++counters.hits;
+            return true;
+        }
+    }
+    ++counters.misses;
+    return false;
+}
+
+void flow_cache::insert(const flow_key &key, const flow_verdict &verdict) {
+    if (entries.empty()) return;
+    size_t first = set_of(key);
+    entry *set = &entries[first];
+    uint8_t &hand = hands[first / WAYS];
+
+    // Advance the clock hand past referenced entries, giving each a second
+    // chance; terminates within two turns since the bits are cleared
+    while (set[hand].used && set[hand].referenced) {
+        set[hand].referenced = false;
+        hand = (hand + 1) % WAYS;
+    }
+    if (set[hand].used) ++counters.evictions;
+    set[hand] = entry{key, verdict, true, false};
+    hand = (hand + 1) % WAYS;
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct flow_key
+ * @brief Addresses and ports identifying an L3 flow.
+ */
+struct flow_key {
+    uint32_t src_ip;    /**< Source address, packed by pack_ipv4 */
+    uint32_t dst_ip;    /**< Destination address, packed by pack_ipv4 */
+    uint16_t src_port;  /**< Source port */
+    uint16_t dst_port;  /**< Destination port */
+
+    bool operator==(const flow_key &other) const {
+        return src_ip == other.src_ip && dst_ip == other.dst_ip &&
+               src_port == other.src_port && dst_port == other.dst_port;
+    }
+};
+
+/**
+ * @struct flow_verdict
+ * @brief Cached forwarding decision of a flow.
+ */
+struct flow_verdict {
+    uint8_t route;       /**< l3_route of the flow */
+    int32_t port_slot;   /**< Open port index for ROUTE_LOCAL, -1 if none */
+};
+
+/**
+ * @struct flow_cache_stats
+ * @brief Flow cache counters.
+ */
+struct flow_cache_stats {
+    uint64_t hits;       /**< Lookups answered from the cache */
+    uint64_t misses;     /**< Lookups that had to compute the verdict */
+    uint64_t evictions;  /**< Entries replaced to make room */
+};
+
+/**
+ * @class flow_cache
+ * @brief Bounded cache of per-flow forwarding decisions.
+ *
+ * A set-associative hash table: a key hashes to one set of WAYS entries,
+ * and when the set is full an entry is evicted with the clock (second
+ * chance) policy - every hit sets the entry's reference bit, and the
+ * set's clock hand skips (and clears) referenced entries. Lookups and
+ * insertions therefore touch a single set and never allocate.
+ *
+ * Verdicts depend on the NIC configuration, so the cache remembers the
+ * nic_context generation it was filled under and sync() drops everything
+ * when it changes. A cache is not thread safe; use one per worker.
+ */
+class flow_cache {
+public:
+    static constexpr size_t WAYS = 4;  /**< Entries per set */
+
+    /**
+     * @fn flow_cache
+     * @brief Construct a cache.
+     *
+     * @param [in] capacity - Number of entries, rounded up to a power of
+     *                        two multiple of WAYS. 0 disables the cache.
+     */
+    explicit flow_cache(size_t capacity = 0);
+
+    /**
+     * @fn capacity
+     * @brief Number of entries the cache holds, 0 if disabled.
+     */
+    size_t capacity() const { return entries.size(); }
+
+    /**
+     * @fn sync
+     * @brief Drop all entries if the configuration changed since they were
+     *        cached.
+     *
+     * @param [in] generation - Current nic_context generation.
+     */
+    void sync(uint64_t generation);
+
+    /**
+     * @fn clear
+     * @brief Drop all entries (counters are kept).
+     */
+    void clear();
+
+    /**
+     * @fn find
+     * @brief Look up a flow.
+     *
+     * @param [in] key      - Flow.
+     * @param [out] verdict - Cached verdict on a hit.
+     *
+     * @return true on a hit, false on a miss.
+     */
+    bool find(const flow_key &key, flow_verdict &verdict);
+
+    /**
+     * @fn insert
+     * @brief Cache the verdict of a flow that was not found.
+     *
+     * @param [in] key     - Flow.
+     * @param [in] verdict - Its verdict.
+     */
+    void insert(const flow_key &key, const flow_verdict &verdict);
+
+    /**
+     * @fn stats
+     * @brief Hit, miss and eviction counters since construction.
+     */
+    flow_cache_stats stats() const { return counters; }
+
+private:
+    struct entry {
+        flow_key key;
+        flow_verdict verdict;
+        bool used;         /**< Entry holds a flow */
+        bool referenced;   /**< Hit since the clock hand last passed */
+    };
+
+    /**
+     * @fn set_of
+     * @brief First entry of the set a key maps to.
+     */
+    size_t set_of(const flow_key &key) const {
+        uint64_t h = (static_cast<uint64_t>(key.src_ip) << 32 | key.dst_ip) * 0x9E3779B97F4A7C15ull;
+        h ^= (static_cast<uint64_t>(key.src_port) << 16 | key.dst_port) * 0xC2B2AE3D27D4EB4Full;
+        return static_cast<size_t>((h >> 32) & set_mask) * WAYS;
+    }
+
+    std::vector<entry> entries;     /**< WAYS entries per set */
+    std::vector<uint8_t> hands;     /**< Clock hand of every set */
+    size_t set_mask;                /**< Number of sets - 1 */
+    uint64_t generation;            /**< Configuration the entries belong to */
+    flow_cache_stats counters;
+};
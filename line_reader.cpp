@@ -0,0 +1,137 @@
+#include "line_reader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Size of a chunk in chunked mode
+static const size_t CHUNK_SIZE = 1 << 16;
+
+line_reader::line_reader(const std::string &path)
+    : fd(-1), owns_fd(false), map(nullptr), map_size(0), map_released(0),
+      pos(0), end(0), eof(false) {
+    if (path == "-") {
+        fd = STDIN_FILENO;
+    } else {
+        fd = ::open(path.c_str(), O_RDONLY);
+        owns_fd = true;
+    }
+    if (fd < 0) {
+        eof = true;
+        return;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        if (st.st_size == 0) {
+            eof = true;
+            return;
+        }
+        void *addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            map = static_cast<const char *>(addr);
+            map_size = st.st_size;
+            ::madvise(addr, map_size, MADV_SEQUENTIAL);
+        }
+    }
+}
+
+line_reader::~line_reader() {
+    if (map) ::munmap(const_cast<char *>(map), map_size);
+    if (owns_fd && fd >= 0) ::close(fd);
+}
+
+bool line_reader::next(std::string_view &line) {
+    if (map) {
+        if (pos >= map_size) return false;
+        const char *start = map + pos;
+        const char *nl = static_cast<const char *>(std::memchr(start, '\n', map_size - pos));
+        size_t len = nl ? static_cast<size_t>(nl - start) : map_size - pos;
+        line = std::string_view(start, len);
+        pos += len + (nl ? 1 : 0);
+        return true;
+    }
+
+    while (true) {
+        const char *start = chunk.data() + pos;
+        const char *nl = (pos < end) ? static_cast<const char *>(std::memchr(start, '\n', end - pos)) : nullptr;
+        if (nl) {
+            line = std::string_view(start, nl - start);
+            pos = nl - chunk.data() + 1;
+            return true;
+        }
+        if (!fill(end - pos + 1)) {
+            if (pos == end) return false;
+            // Last line without a trailing newline
+            line = std::string_view(chunk.data() + pos, end - pos);
+            pos = end;
+            return true;
+        }
+    }
+}
+
+bool line_reader::peek(size_t size, std::string_view &bytes) {
+    if (map) {
+        if (map_size - pos < size) return false;
+        bytes = std::string_view(map + pos, size);
+        return true;
+    }
+
+    while (end - pos < size) {
+        if (!fill(size)) return false;
+    }
+    bytes = std::string_view(chunk.data() + pos, size);
+    return true;
+}
+
+bool line_reader::read(size_t size, std::string_view &bytes) {
+    if (!peek(size, bytes)) return false;
+    pos += size;
+    return true;
+}
+
+bool line_reader::fill(size_t need) {
+    if (eof) return false;
+
+    if (end == chunk.size() || pos + need > chunk.size()) {
+        // Chunk is full: earlier lines may still be referenced, so move the
+        // partial line to a new chunk instead of reallocating this one.
+        size_t tail = end - pos;
+        std::vector<char> next_chunk(std::max({CHUNK_SIZE, 2 * tail, need}));
+        std::memcpy(next_chunk.data(), chunk.data() + pos, tail);
+        if (!chunk.empty()) retired.push_back(std::move(chunk));
+        chunk = std::move(next_chunk);
+        pos = 0;
+        end = tail;
+    }
+
+    while (true) {
+        ssize_t n = ::read(fd, chunk.data() + end, chunk.size() - end);
+        if (n > 0) {
+            end += n;
+            return true;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        eof = true;
+        return false;
+    }
+}
+
+void line_reader::release() {
+    if (map) {
+        // Drop the pages already consumed to keep the resident size constant
+        size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        size_t upto = pos / page * page;
+        if (upto > map_released) {
+            ::madvise(const_cast<char *>(map) + map_released, upto - map_released, MADV_DONTNEED);
+            map_released = upto;
+        }
+        return;
+    }
+
+    retired.clear();
+    if (pos == end) pos = end = 0;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class line_reader
+ * @brief Reads a text file line by line without copying lines.
+ *
+ * Fixed-size byte ranges can be read as well, for binary traces.
+ * Regular files are memory mapped and lines are handed out as views into
+ * the mapping. Pipes and stdin ("-") fall back to buffered chunked reads.
+ * Lines returned by next() stay valid until the following release() call,
+ * which lets the reader drop everything consumed so far, so memory use is
+ * bounded by what the caller holds between releases.
+ */
+class line_reader {
+public:
+    /**
+     * @fn line_reader
+     * @brief Open a file for reading.
+     *
+     * @param [in] path - File name, or "-" for stdin.
+     */
+    explicit line_reader(const std::string &path);
+
+    /**
+     * @fn ~line_reader
+     * @brief Unmap / close the file.
+     */
+    ~line_reader();
+
+    line_reader(const line_reader &) = delete;
+    line_reader &operator=(const line_reader &) = delete;
+
+    /**
+     * @fn is_open
+     * @brief Check whether the file was opened successfully.
+     */
+    bool is_open() const { return fd >= 0; }
+
+    /**
+     * @fn next
+     * @brief Get the next line, without its trailing '\n'.
+     *
+     * @param [out] line - View of the line, valid until release().
+     *
+     * @return true if a line was read, false at end of file.
+     */
+    bool next(std::string_view &line);
+
+    /**
+     * @fn read
+     * @brief Get the next size bytes.
+     *
+     * @param [in] size   - Number of bytes.
+     * @param [out] bytes - View of the bytes, valid until release().
+     *
+     * @return true on success, false if fewer than size bytes are left.
+     */
+    bool read(size_t size, std::string_view &bytes);
+
+    /**
+     * @fn peek
+     * @brief Like read(), but the bytes are not consumed.
+     */
+    bool peek(size_t size, std::string_view &bytes);
+
+    /**
+     * @fn release
+     * @brief Invalidate all lines returned so far and free their memory.
+     */
+    void release();
+
+private:
+    /**
+     * @fn fill
+     * @brief Read more data into the chunk buffer (chunked mode).
+     *
+     * @param [in] need - Bytes from pos that must fit in the chunk.
+     *
+     * @return true if any data was read.
+     */
+    bool fill(size_t need);
+
+    int fd;                   /**< File descriptor, -1 if not open */
+    bool owns_fd;             /**< false for stdin */
+
+    const char *map;          /**< File mapping, nullptr in chunked mode */
+    size_t map_size;          /**< Size of the mapping */
+    size_t map_released;      /**< Page aligned offset already released */
+
+    std::vector<char> chunk;                /**< Current chunk buffer */
+    std::vector<std::vector<char>> retired; /**< Older chunks still referenced */
+    size_t pos;               /**< Next unread byte (mapping or chunk) */
+    size_t end;               /**< End of valid data in chunk */
+    bool eof;                 /**< No more data to read */
+};
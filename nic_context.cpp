@@ -0,0 +1,28 @@
+#include "nic_context.hpp"
+#include <cstring>
+
+nic_context::nic_context() : mac{}, ip{}, mask(0), ip_addr(0), netmask(0), mac_addr(0), generation(1) {}
+
+nic_context::nic_context(const uint8_t ip_[IP_V4_SIZE], uint8_t mask, const uint8_t mac_[MAC_SIZE])
+    : mac{}, ip{}, mask(0), ip_addr(0), netmask(0), mac_addr(0), generation(1) {
+    if (ip_) set_address(ip_, mask);
+    if (mac_) set_mac(mac_);
+}
+
+nic_context::nic_context(const open_port_vec &open_ports, const uint8_t ip_[IP_V4_SIZE], uint8_t mask, const uint8_t mac_[MAC_SIZE])
+    : ports(open_ports), mac{}, ip{}, mask(0), ip_addr(0), netmask(0), mac_addr(0), generation(1) {
+    if (ip_) set_address(ip_, mask);
+    if (mac_) set_mac(mac_);
+}
+
+void nic_context::set_address(const uint8_t ip_[IP_V4_SIZE], uint8_t mask_) {
+    std::memcpy(ip, ip_, IP_V4_SIZE);
+    mask = mask_;
+    ip_addr = pack_ipv4(ip);
+    netmask = prefix_netmask(mask);
+}
+
+void nic_context::set_mac(const uint8_t mac_[MAC_SIZE]) {
+    std::memcpy(mac, mac_, MAC_SIZE);
+    mac_addr = pack_mac(mac);
+}
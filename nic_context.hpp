@@ -0,0 +1,130 @@
+#pragma once
+#include "packets.hpp"
+#include "port_table.hpp"
+#include "route_table.hpp"
+#include <cstdint>
+
+/**
+ * @struct nic_context
+ * @brief Read-only NIC configuration handed to every packet layer.
+ *
+ * Bundles the open port index and routing table with the NIC's IP, mask
+ * and MAC so that validation and processing receive a single object by
+ * const reference instead of copies of the open port vector.
+ */
+struct nic_context {
+    /**
+     * @fn nic_context
+     * @brief Construct an empty context.
+     */
+    nic_context();
+
+    /**
+     * @fn nic_context
+     * @brief Construct a context with an empty port index.
+     *
+     * Cheap enough to build per call, for the generic_packet overloads that
+     * look their ports up in the vector directly.
+     *
+     * @param [in] ip   - NIC's IP address, may be nullptr.
+     * @param [in] mask - NIC's mask.
+     * @param [in] mac  - NIC's MAC address, may be nullptr.
+     */
+    nic_context(const uint8_t ip[IP_V4_SIZE], uint8_t mask, const uint8_t mac[MAC_SIZE]);
+
+    /**
+     * @fn nic_context
+     * @brief Construct a context from the generic_packet arguments.
+     *
+     * Builds the port index, so it is meant to be built once per
+     * configuration, not per packet.
+     *
+     * @param [in] open_ports - Vector containing all the NIC's open ports.
+     * @param [in] ip         - NIC's IP address.
+     * @param [in] mask       - NIC's mask.
+     * @param [in] mac        - NIC's MAC address, may be nullptr.
+     */
+    nic_context(const open_port_vec &open_ports, const uint8_t ip[IP_V4_SIZE], uint8_t mask, const uint8_t mac[MAC_SIZE]);
+
+    /**
+     * @fn set_address
+     * @brief Set the NIC's IP address and mask (and their packed forms).
+     *
+     * @param [in] ip   - NIC's IP address.
+     * @param [in] mask - NIC's mask.
+     */
+    void set_address(const uint8_t ip[IP_V4_SIZE], uint8_t mask);
+
+    /**
+     * @fn set_mac
+     * @brief Set the NIC's MAC address (and its packed form).
+     *
+     * @param [in] mac - NIC's MAC address.
+     */
+    void set_mac(const uint8_t mac[MAC_SIZE]);
+
+    /**
+     * @fn config_changed
+     * @brief Must be called after the configuration (address, ports or
+     *        routes) changes: bumps the generation, which invalidates the
+     *        decisions flow caches hold.
+     */
+    void config_changed() { ++generation; }
+
+    open_port_table ports;    /**< Index of the NIC's open ports */
+    route_table routes;       /**< Per-prefix forwarding, empty for a single subnet */
+    uint8_t mac[MAC_SIZE];    /**< NIC's MAC address */
+    uint8_t ip[IP_V4_SIZE];   /**< NIC's IP address */
+    uint8_t mask;             /**< NIC's mask */
+    uint32_t ip_addr;         /**< NIC's IP address, packed by pack_ipv4 */
+    uint32_t netmask;         /**< NIC's mask as a 32-bit netmask */
+    uint64_t mac_addr;        /**< NIC's MAC address, packed by pack_mac */
+    uint64_t generation;      /**< Bumped on every configuration change */
+};
+
+/**
+ * @fn pack_ipv4
+ * @brief Pack an IPv4 address into an integer, first byte most significant.
+ */
+inline uint32_t pack_ipv4(const uint8_t ip[IP_V4_SIZE]) {
+    return (static_cast<uint32_t>(ip[0]) << 24) | (static_cast<uint32_t>(ip[1]) << 16) |
+           (static_cast<uint32_t>(ip[2]) << 8) | ip[3];
+}
+
+/**
+ * @fn unpack_ipv4
+ * @brief Inverse of pack_ipv4.
+ */
+inline void unpack_ipv4(uint32_t addr, uint8_t ip[IP_V4_SIZE]) {
+    for (int i = IP_V4_SIZE - 1; i >= 0; --i, addr >>= 8) ip[i] = static_cast<uint8_t>(addr);
+}
+
+/**
+ * @fn pack_mac
+ * @brief Pack a MAC address into the low 48 bits of an integer, first byte
+ *        most significant.
+ */
+inline uint64_t pack_mac(const uint8_t mac[MAC_SIZE]) {
+    uint64_t addr = 0;
+    for (int i = 0; i < MAC_SIZE; ++i) addr = (addr << 8) | mac[i];
+    return addr;
+}
+
+/**
+ * @fn unpack_mac
+ * @brief Inverse of pack_mac.
+ */
+inline void unpack_mac(uint64_t addr, uint8_t mac[MAC_SIZE]) {
+    for (int i = MAC_SIZE - 1; i >= 0; --i, addr >>= 8) mac[i] = static_cast<uint8_t>(addr);
+}
+
+/**
+ * @fn prefix_netmask
+ * @brief Convert a prefix length to a 32-bit netmask (lengths above 32
+ *        mean the whole address).
+ */
+inline uint32_t prefix_netmask(uint8_t mask) {
+    if (mask == 0) return 0;
+    if (mask >= 32) return 0xFFFFFFFFu;
+    return 0xFFFFFFFFu << (32 - mask);
+}
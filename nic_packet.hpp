@@ -0,0 +1,66 @@
+#pragma once
+#include "packets.hpp"
+#include "nic_context.hpp"
+#include "packet_arena.hpp"
+#include <memory>
+#include <cstddef>
+
+/**
+ * @class nic_packet
+ * @brief Extension of the generic_packet interface used by the simulator.
+ *
+ * Adds overloads that receive the NIC configuration as one immutable
+ * nic_context by const reference, so validating a packet never copies the
+ * open ports and looks them up in O(1). The generic_packet methods stay
+ * available for compatibility.
+ */
+class nic_packet : public generic_packet {
+public:
+    using generic_packet::validate_packet;
+    using generic_packet::proccess_packet;
+
+    /**
+     * @fn validate_packet
+     * @brief Check whether the packet is valid.
+     *
+     * @param [in] ctx - NIC configuration.
+     *
+     * @return true if the packet is valid, false otherwise.
+     */
+    virtual bool validate_packet(const nic_context &ctx) const = 0;
+
+    /**
+     * @fn proccess_packet
+     * @brief Modify the packet and return the memory location it should be stored in.
+     *
+     * @param [in] ctx            - NIC configuration.
+     * @param [in,out] open_ports - Vector containing all the NIC's open ports.
+     * @param [out] dst           - Reference to enum indicating the memory space.
+     *
+     * @return true on success, false on failure.
+     */
+    virtual bool proccess_packet(const nic_context &ctx, open_port_vec &open_ports, memory_dest &dst) = 0;
+
+    /**
+     * @fn string_size
+     * @brief Upper bound on the length of the packet's string representation.
+     */
+    virtual size_t string_size() const = 0;
+
+    /**
+     * @fn write_string
+     * @brief Write the packet's string representation (the same text
+     *        as_string produces) into a buffer.
+     *
+     * @param [out] out - Output buffer, at least string_size() bytes.
+     *
+     * @return End of the written text.
+     */
+    virtual char *write_string(char *out) const = 0;
+};
+
+/**
+ * @typedef packet_ptr
+ * @brief Owning pointer to a packet created in a packet_arena.
+ */
+typedef std::unique_ptr<nic_packet, arena_deleter> packet_ptr;
@@ -0,0 +1,82 @@
+#include "nic_stats.hpp"
+#include <cstring>
+
+static const char *const DROP_NAMES[DROP_REASON_COUNT] = {
+    "parse_error", "bad_mac", "l2_checksum", "l3_checksum",
+    "ttl_expired", "no_open_port", "dram_out_of_range", "route_drop"
+};
+
+static const char *const STAGE_NAMES[STAGE_COUNT] = {
+    "parse", "validate", "process", "serialize"
+};
+
+stats_shard::stats_shard() {
+    packets = 0;
+    std::memset(stored, 0, sizeof(stored));
+    std::memset(drops, 0, sizeof(drops));
+    std::memset(stage_count, 0, sizeof(stage_count));
+    std::memset(stage_ns, 0, sizeof(stage_ns));
+    std::memset(hist, 0, sizeof(hist));
+}
+
+void stats_shard::add(const stats_shard &other) {
+    packets += other.packets;
+    for (size_t i = 0; i < 3; ++i) stored[i] += other.stored[i];
+    for (size_t i = 0; i < DROP_REASON_COUNT; ++i) drops[i] += other.drops[i];
+    for (size_t s = 0; s < STAGE_COUNT; ++s) {
+        stage_count[s] += other.stage_count[s];
+        stage_ns[s] += other.stage_ns[s];
+        for (size_t b = 0; b < HIST_BUCKETS; ++b) hist[s][b] += other.hist[s][b];
+    }
+}
+
+void stats_shard::record_ns(flow_stage stage, uint64_t ns, size_t count) {
+    uint64_t per_packet = ns / count;
+    size_t bucket = 0;
+    while (bucket + 1 < HIST_BUCKETS && (per_packet >> bucket) != 0) ++bucket;
+    stage_count[stage] += count;
+    stage_ns[stage] += ns;
+    hist[stage][bucket] += count;
+}
+
+void nic_stats::resize(size_t threads) {
+    if (shards.size() < threads) shards.resize(threads);
+}
+
+stats_shard nic_stats::total() const {
+    stats_shard sum;
+    for (const auto &s : shards) sum.add(s);
+    return sum;
+}
+
+void nic_stats::dump_json(std::ostream &out) const {
+    if (!NIC_STATS_ENABLED) {
+        out << "{\"enabled\": false}\n";
+        return;
+    }
+
+    stats_shard t = total();
+    out << "{\n  \"enabled\": true,\n  \"packets\": " << t.packets << ",\n";
+    out << "  \"stored\": {\"local_dram\": " << t.stored[LOCAL_DRAM] << ", \"rq\": " << t.stored[RQ]
+        << ", \"tq\": " << t.stored[TQ] << "},\n";
+
+    out << "  \"drops\": {";
+    for (size_t i = 0; i < DROP_REASON_COUNT; ++i)
+        out << (i ? ", " : "") << '"' << DROP_NAMES[i] << "\": " << t.drops[i];
+    out << "},\n";
+
+    out << "  \"stages\": {\n";
+    for (size_t s = 0; s < STAGE_COUNT; ++s) {
+        out << "    \"" << STAGE_NAMES[s] << "\": {\"count\": " << t.stage_count[s]
+            << ", \"total_ns\": " << t.stage_ns[s] << ", \"histogram_ns\": {";
+        bool first = true;
+        for (size_t b = 0; b < stats_shard::HIST_BUCKETS; ++b) {
+            if (!t.hist[s][b]) continue;
+            // Key is the bucket's exclusive upper bound
+            out << (first ? "" : ", ") << "\"<" << (static_cast<uint64_t>(1) << b) << "\": " << t.hist[s][b];
+            first = false;
+        }
+        out << "}}" << (s + 1 < STAGE_COUNT ? "," : "") << "\n";
+    }
+    out << "  }\n}\n";
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include "packets.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+/**
+ * Counters and stage timers of nic_flow. They are only collected when the
+ * simulator is compiled with -DNIC_STATS (make STATS=1); otherwise every
+ * recording call below is an empty inline function and the clock is never
+ * read, so the instrumentation costs nothing.
+ */
+#ifdef NIC_STATS
+static constexpr bool NIC_STATS_ENABLED = true;
+#else
+static constexpr bool NIC_STATS_ENABLED = false;
+#endif
+
+/**
+ * @enum drop_reason
+ * @brief Why a packet was not stored anywhere.
+ */
+enum drop_reason {
+    DROP_PARSE,          /**< Line or record could not be parsed */
+    DROP_BAD_MAC,        /**< L2 destination is not the NIC's MAC */
+    DROP_L2_CHECKSUM,    /**< L2 checksum mismatch */
+    DROP_L3_CHECKSUM,    /**< L3 checksum mismatch */
+    DROP_TTL_EXPIRED,    /**< TTL was or became 0 */
+    DROP_NO_PORT,        /**< No open port for the packet's ports */
+    DROP_DRAM_RANGE,     /**< Data does not fit in the port's LOCAL DRAM */
+    DROP_ROUTE,          /**< Routed to drop (internal traffic or a DROP route) */
+    DROP_REASON_COUNT
+};
+
+/**
+ * @enum flow_stage
+ * @brief Timed stages of nic_flow.
+ */
+enum flow_stage {
+    STAGE_PARSE,         /**< Text or binary record to packet */
+    STAGE_VALIDATE,      /**< Batched validation and routing */
+    STAGE_PROCESS,       /**< Applying the route (forwarding, DRAM writes) */
+    STAGE_SERIALIZE,     /**< Packet to string and queue push */
+    STAGE_COUNT
+};
+
+typedef std::chrono::steady_clock stats_clock;
+
+/**
+ * @struct stats_shard
+ * @brief Counters of one thread, on their own cache lines.
+ *
+ * Latencies are kept as log2 histograms in nanoseconds: bucket b counts
+ * samples in [2^(b-1), 2^b), and the last bucket also holds anything
+ * longer.
+ */
+struct alignas(64) stats_shard {
+    static constexpr size_t HIST_BUCKETS = 32;  /**< Buckets up to ~1 s */
+
+    uint64_t packets;                           /**< Packets read */
+    uint64_t stored[3];                         /**< Packets per memory_dest */
+    uint64_t drops[DROP_REASON_COUNT];          /**< Packets per drop_reason */
+    uint64_t stage_count[STAGE_COUNT];          /**< Samples per stage */
+    uint64_t stage_ns[STAGE_COUNT];             /**< Total time per stage */
+    uint64_t hist[STAGE_COUNT][HIST_BUCKETS];   /**< Latency histograms */
+
+    /**
+     * @fn stats_shard
+     * @brief Construct zeroed counters.
+     */
+    stats_shard();
+
+    /**
+     * @fn add
+     * @brief Add another shard's counters to this one.
+     */
+    void add(const stats_shard &other);
+
+    void count_packet() {
+        if constexpr (NIC_STATS_ENABLED) ++packets;
+    }
+
+    void drop(drop_reason reason) {
+        if constexpr (NIC_STATS_ENABLED) ++drops[reason];
+    }
+
+    void store(memory_dest dst) {
+        if constexpr (NIC_STATS_ENABLED) ++stored[dst];
+    }
+
+    /**
+     * @fn start
+     * @brief Start time of a stage sample (not read when compiled out).
+     */
+    static stats_clock::time_point start() {
+        if constexpr (NIC_STATS_ENABLED) return stats_clock::now();
+        else return stats_clock::time_point();
+    }
+
+    /**
+     * @fn record
+     * @brief Record the time since start as count samples of a stage: one
+     *        packet, or a batch of count packets timed as a whole (each
+     *        packet is charged the average).
+     *
+     * @param [in] stage - Stage.
+     * @param [in] begin - Value returned by start().
+     * @param [in] count - Number of packets the time covers.
+     */
+    void record(flow_stage stage, stats_clock::time_point begin, size_t count = 1) {
+        if constexpr (NIC_STATS_ENABLED) {
+            if (count == 0) return;
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(stats_clock::now() - begin).count();
+            record_ns(stage, static_cast<uint64_t>(ns), count);
+        }
+    }
+
+private:
+    void record_ns(flow_stage stage, uint64_t ns, size_t count);
+};
+
+/**
+ * @class nic_stats
+ * @brief Per-thread stats shards of a simulator.
+ */
+class nic_stats {
+public:
+    /**
+     * @fn resize
+     * @brief Make sure there is a shard for every thread (existing counts
+     *        are kept).
+     *
+     * @param [in] threads - Number of threads.
+     */
+    void resize(size_t threads);
+
+    /**
+     * @fn shard
+     * @brief Counters of a thread. Only that thread may record into them.
+     */
+    stats_shard &shard(size_t thread) { return shards[thread]; }
+
+    /**
+     * @fn total
+     * @brief Sum of all shards.
+     */
+    stats_shard total() const;
+
+    /**
+     * @fn dump_json
+     * @brief Write the summed counters as a JSON object.
+     *
+     * @param [in] out - Output stream.
+     */
+    void dump_json(std::ostream &out) const;
+
+private:
+    std::vector<stats_shard> shards;
+};
@@ -0,0 +1,33 @@
+#include "packet_arena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+packet_arena::packet_arena(size_t block_size) : current(0), offset(0) {
+    blocks.push_back(block{std::unique_ptr<char[]>(new char[block_size]), block_size});
+}
+
+void *packet_arena::do_allocate(size_t bytes, size_t alignment) {
+    while (true) {
+        block &cur = blocks[current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(cur.data.get());
+        size_t start = ((base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+        if (start + bytes <= cur.size) {
+            offset = start + bytes;
+            return cur.data.get() + start;
+        }
+
+        // Move on to the next block, growing the arena if there is none
+        // large enough left
+        ++current;
+        offset = 0;
+        if (current == blocks.size() || blocks[current].size < bytes + alignment) {
+            size_t size = std::max(2 * cur.size, bytes + alignment);
+            blocks.insert(blocks.begin() + current, block{std::unique_ptr<char[]>(new char[size]), size});
+        }
+    }
+}
+
+void packet_arena::reset() {
+    current = 0;
+    offset = 0;
+}
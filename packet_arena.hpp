@@ -0,0 +1,82 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * @class packet_arena
+ * @brief Bump allocator that the packets of one batch and their data
+ *        buffers are carved from.
+ *
+ * Allocation is a pointer bump and deallocation is a no-op; everything is
+ * freed at once by reset(), which rewinds the arena but keeps its blocks, so
+ * steady state batches do not call malloc at all. Usable as a
+ * std::pmr::memory_resource for containers. Not thread safe, use one arena
+ * per thread.
+ */
+class packet_arena : public std::pmr::memory_resource {
+public:
+    /**
+     * @fn packet_arena
+     * @brief Construct an arena.
+     *
+     * @param [in] block_size - Size of the first block in bytes.
+     */
+    explicit packet_arena(size_t block_size = 1 << 16);
+
+    packet_arena(const packet_arena &) = delete;
+    packet_arena &operator=(const packet_arena &) = delete;
+
+    /**
+     * @fn create
+     * @brief Construct an object in the arena.
+     *
+     * The object must be destroyed (not deleted) before reset(), e.g. by
+     * holding it in an arena_ptr. Objects start on a cache line, so a
+     * packet's headers do not straddle two.
+     */
+    template <class T, class... Args>
+    T *create(Args&&... args) {
+        void *mem = allocate(sizeof(T), std::max(alignof(T), CACHE_LINE_SIZE));
+        return ::new (mem) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @fn reset
+     * @brief Free everything allocated from the arena at once.
+     */
+    void reset();
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    std::vector<block> blocks;  /**< Blocks in allocation order */
+    size_t current;             /**< Block being allocated from */
+    size_t offset;              /**< Next free byte in the current block */
+};
+
+/**
+ * @struct arena_deleter
+ * @brief unique_ptr deleter for objects created in a packet_arena: runs the
+ *        destructor only, the memory is freed by packet_arena::reset().
+ */
+struct arena_deleter {
+    template <class T>
+    void operator()(T *ptr) const { ptr->~T(); }
+};
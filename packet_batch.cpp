@@ -0,0 +1,159 @@
+#include "packet_batch.hpp"
+#include "checksum.hpp"
+
+packet_batch::packet_batch(packet_layer layer) : layer(layer) {}
+
+void packet_batch::clear() {
+    position.clear();
+    src_mac.clear();
+    dst_mac.clear();
+    l2_checksum.clear();
+    src_ip.clear();
+    dst_ip.clear();
+    ttl.clear();
+    l3_checksum.clear();
+    src_port.clear();
+    dst_port.clear();
+    address.clear();
+    data_size.clear();
+    payload.clear();
+    data_sum.clear();
+    valid.clear();
+    route.clear();
+    port_slot.clear();
+}
+
+void packet_batch::add(const nic_packet &pkt, uint32_t pos) {
+    const l3_packet *l3 = nullptr;
+    const l4_packet *l4;
+    if (layer == LAYER_L2) {
+        const l2_packet &l2 = static_cast<const l2_packet &>(pkt);
+        src_mac.push_back(l2.src_mac);
+        dst_mac.push_back(l2.dst_mac);
+        l2_checksum.push_back(l2.checksum);
+        l3 = &l2.payload;
+    } else if (layer == LAYER_L3) {
+        l3 = &static_cast<const l3_packet &>(pkt);
+    }
+    if (l3) {
+        src_ip.push_back(l3->src_ip);
+        dst_ip.push_back(l3->dst_ip);
+        ttl.push_back(l3->ttl);
+        l3_checksum.push_back(l3->checksum);
+        l4 = &l3->payload;
+    } else {
+        l4 = &static_cast<const l4_packet &>(pkt);
+    }
+
+    position.push_back(pos);
+    src_port.push_back(l4->src_port);
+    dst_port.push_back(l4->dst_port);
+    address.push_back(l4->address);
+    data_size.push_back(static_cast<uint32_t>(l4->data_size()));
+    payload.push_back(l4);
+    data_sum.push_back(0);
+    valid.push_back(0);
+    route.push_back(ROUTE_DROP);
+    port_slot.push_back(-1);
+}
+
+void packet_batch::validate(const nic_context &ctx, size_t begin, size_t end) {
+    if (layer == LAYER_L4) {
+        for (size_t i = begin; i < end; ++i)
+            valid[i] = ctx.ports.find(src_port[i], dst_port[i]) != -1;
+        return;
+    }
+
+    for (size_t i = begin; i < end; ++i) data_sum[i] = payload[i]->data_checksum();
+    for (size_t i = begin; i < end; ++i) {
+        uint32_t l3 = l3_sum(i);
+        bool ok = static_cast<uint16_t>(l3) == l3_checksum[i] && ttl[i] > 0;
+        if (layer == LAYER_L2)
+            ok = ok && dst_mac[i] == ctx.mac_addr && static_cast<uint16_t>(l2_sum(i, l3)) == l2_checksum[i];
+        valid[i] = ok;
+    }
+}
+
+// Same sums as l3_packet::calc_checksum / l2_packet::calc_checksum
+// (note the address contributes address >> 8, not just its second byte)
+inline uint32_t packet_batch::l3_sum(size_t i) const {
+    return sum_u32(src_ip[i]) + sum_u32(dst_ip[i]) + ttl[i] + sum_u16(src_port[i]) + sum_u16(dst_port[i]) +
+           (address[i] >> 8) + (address[i] & 0xFF) + data_sum[i];
+}
+
+inline uint32_t packet_batch::l2_sum(size_t i, uint32_t l3) const {
+    return sum_u48(src_mac[i]) + sum_u48(dst_mac[i]) + l3 + sum_u16(l3_checksum[i]);
+}
+
+void packet_batch::classify(const nic_context &ctx, size_t begin, size_t end, flow_cache *cache) {
+    if (layer == LAYER_L4) {
+        for (size_t i = begin; i < end; ++i) {
+            port_slot[i] = ctx.ports.find(src_port[i], dst_port[i]);
+            route[i] = port_slot[i] != -1 ? ROUTE_LOCAL : ROUTE_DROP;
+        }
+        return;
+    }
+
+    if (cache && cache->capacity()) {
+        for (size_t i = begin; i < end; ++i) {
+            flow_key key{src_ip[i], dst_ip[i], src_port[i], dst_port[i]};
+            flow_verdict verdict;
+            if (!cache->find(key, verdict)) {
+                verdict.route = l3_packet::route(src_ip[i], dst_ip[i], ctx);
+                verdict.port_slot = verdict.route == ROUTE_LOCAL ? ctx.ports.find(src_port[i], dst_port[i]) : -1;
+                cache->insert(key, verdict);
+            }
+            route[i] = verdict.route;
+            port_slot[i] = verdict.port_slot;
+        }
+        return;
+    }
+
+    for (size_t i = begin; i < end; ++i)
+        route[i] = l3_packet::route(src_ip[i], dst_ip[i], ctx);
+    for (size_t i = begin; i < end; ++i) {
+        if (route[i] == ROUTE_LOCAL) port_slot[i] = ctx.ports.find(src_port[i], dst_port[i]);
+    }
+}
+
+drop_reason packet_batch::drop_cause(size_t i, const nic_context &ctx) const {
+    if (layer == LAYER_L4) return port_slot[i] == -1 ? DROP_NO_PORT : DROP_DRAM_RANGE;
+
+    if (!valid[i]) {
+        // Checks in the order validate_packet / proccess_packet make them
+        uint32_t l3 = l3_sum(i);
+        if (layer == LAYER_L2) {
+            if (dst_mac[i] != ctx.mac_addr) return DROP_BAD_MAC;
+            if (static_cast<uint16_t>(l2_sum(i, l3)) != l2_checksum[i]) return DROP_L2_CHECKSUM;
+        }
+        if (static_cast<uint16_t>(l3) != l3_checksum[i]) return DROP_L3_CHECKSUM;
+        return DROP_TTL_EXPIRED;
+    }
+
+    // Valid but dropped while applying its route
+    switch (route[i]) {
+    case ROUTE_DROP:  return DROP_ROUTE;
+    case ROUTE_LOCAL: return port_slot[i] == -1 ? DROP_NO_PORT : DROP_DRAM_RANGE;
+    default:          return DROP_TTL_EXPIRED;
+    }
+}
+
+uint32_t packet_batch::flow_hash(size_t i) const {
+    uint64_t key = static_cast<uint64_t>(src_port[i]) << 16 | dst_port[i];
+    if (layer != LAYER_L4 && route[i] != ROUTE_LOCAL)
+        key ^= (static_cast<uint64_t>(src_ip[i]) << 32 | dst_ip[i]) * 0xC2B2AE3D27D4EB4Full;
+    return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+bool packet_batch::apply(size_t i, nic_packet &pkt, const nic_context &ctx, open_port_vec &open_ports, memory_dest &dst) const {
+    l3_route r = static_cast<l3_route>(route[i]);
+    switch (layer) {
+    case LAYER_L2:
+        return static_cast<l2_packet &>(pkt).payload.apply_route(r, port_slot[i], ctx, open_ports, dst);
+    case LAYER_L3:
+        return static_cast<l3_packet &>(pkt).apply_route(r, port_slot[i], ctx, open_ports, dst);
+    default:
+        if (port_slot[i] == -1) return false;
+        return static_cast<l4_packet &>(pkt).write_dram(open_ports[port_slot[i]], dst);
+    }
+}
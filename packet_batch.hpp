@@ -0,0 +1,157 @@
+#pragma once
+#include "L2.h"
+#include "L3.h"
+#include "L4.h"
+#include "nic_context.hpp"
+#include "flow_cache.hpp"
+#include "nic_stats.hpp"
+#include "packet_parser.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class packet_batch
+ * @brief Structure-of-arrays view of a batch of packets of one layer.
+ *
+ * The header fields needed to validate and route the packets are copied
+ * into contiguous per-field arrays, so validate() and classify() run as
+ * tight non-virtual loops over the whole batch that the compiler can
+ * vectorize. The packets themselves are then only touched to apply the
+ * precomputed verdicts, in input order. Data bytes are not copied: add()
+ * keeps a pointer to each packet's L4 part and validate() sums its data,
+ * so that pass runs on the worker pool with the rest of validation.
+ */
+class packet_batch {
+public:
+    /**
+     * @fn packet_batch
+     * @brief Construct an empty batch.
+     *
+     * @param [in] layer - Layer of all packets in the batch.
+     */
+    explicit packet_batch(packet_layer layer);
+
+    /**
+     * @fn size
+     * @brief Number of packets in the batch.
+     */
+    size_t size() const { return position.size(); }
+
+    /**
+     * @fn clear
+     * @brief Remove all packets, keeping the allocated capacity.
+     */
+    void clear();
+
+    /**
+     * @fn add
+     * @brief Append a packet's fields to the batch.
+     *
+     * @param [in] pkt - Packet, must be of the batch's layer. It must
+     *                   outlive the batch's use, which reads its data.
+     * @param [in] pos - Position of the packet in the input.
+     */
+    void add(const nic_packet &pkt, uint32_t pos);
+
+    /**
+     * @fn validate
+     * @brief Set valid[i] for packets [begin, end): the same checks
+     *        validate_packet and the start of proccess_packet perform
+     *        (MAC, L2/L3 checksums, TTL, open port for L4 packets). Sets
+     *        data_sum[i] first for L2/L3 packets.
+     *
+     * @param [in] ctx   - NIC configuration.
+     * @param [in] begin - First packet.
+     * @param [in] end   - One past the last packet.
+     */
+    void validate(const nic_context &ctx, size_t begin, size_t end);
+
+    /**
+     * @fn classify
+     * @brief Set route[i] and port_slot[i] for packets [begin, end).
+     *
+     * @param [in] ctx       - NIC configuration.
+     * @param [in] begin     - First packet.
+     * @param [in] end       - One past the last packet.
+     * @param [in,out] cache - Flow cache consulted for L2/L3 packets, may
+     *                         be nullptr. Must be synced with ctx.
+     */
+    void classify(const nic_context &ctx, size_t begin, size_t end, flow_cache *cache = nullptr);
+
+    /**
+     * @fn apply
+     * @brief Process packet i along its precomputed route.
+     *
+     * @param [in] i              - Index in the batch.
+     * @param [in,out] pkt        - The packet added at index i.
+     * @param [in] ctx            - NIC configuration.
+     * @param [in,out] open_ports - Vector containing all the NIC's open ports.
+     * @param [out] dst           - Reference to enum indicating the memory space.
+     *
+     * @return true on success, false if the packet is dropped.
+     */
+    bool apply(size_t i, nic_packet &pkt, const nic_context &ctx, open_port_vec &open_ports, memory_dest &dst) const;
+
+    /**
+     * @fn drop_cause
+     * @brief Why packet i was dropped, either by validate() or by apply().
+     *        Recomputes the checks, so it is meant for the (cold) stats path.
+     *
+     * @param [in] i   - Index in the batch of a dropped packet.
+     * @param [in] ctx - NIC configuration.
+     *
+     * @return The first check the packet fails.
+     */
+    drop_reason drop_cause(size_t i, const nic_context &ctx) const;
+
+    /**
+     * @fn flow_hash
+     * @brief RSS hash of packet i, after classify(). Packets that write to
+     *        LOCAL DRAM hash on their port pair only, so all packets of an
+     *        open port get the same hash; others hash on the whole
+     *        address/port tuple.
+     *
+     * @param [in] i - Index in the batch.
+     *
+     * @return The hash.
+     */
+    uint32_t flow_hash(size_t i) const;
+
+    packet_layer layer;                 /**< Layer of all packets */
+
+    std::vector<uint32_t> position;     /**< Position in the input */
+    std::vector<uint64_t> src_mac;      /**< L2: packed source MAC */
+    std::vector<uint64_t> dst_mac;      /**< L2: packed destination MAC */
+    std::vector<uint16_t> l2_checksum;  /**< L2: checksum */
+    std::vector<uint32_t> src_ip;       /**< L2/L3: packed source IP */
+    std::vector<uint32_t> dst_ip;       /**< L2/L3: packed destination IP */
+    std::vector<uint8_t>  ttl;          /**< L2/L3: TTL */
+    std::vector<uint16_t> l3_checksum;  /**< L2/L3: checksum */
+    std::vector<uint16_t> src_port;     /**< Source port */
+    std::vector<uint16_t> dst_port;     /**< Destination port */
+    std::vector<uint32_t> address;      /**< Data offset in LOCAL DRAM */
+    std::vector<uint32_t> data_size;    /**< Number of data bytes */
+    std::vector<const l4_packet *> payload; /**< L4 part of each packet */
+    std::vector<uint16_t> data_sum;     /**< L2/L3: byte sum of the data, set by validate() */
+
+    std::vector<uint8_t>  valid;        /**< Output of validate() */
+    std::vector<uint8_t>  route;        /**< Output of classify(), an l3_route */
+    std::vector<int32_t>  port_slot;    /**< Output of classify(), -1 if none */
+
+private:
+    /**
+     * @fn l3_sum
+     * @brief Byte sum l3_packet::calc_checksum computes for packet i.
+     */
+    uint32_t l3_sum(size_t i) const;
+
+    /**
+     * @fn l2_sum
+     * @brief Byte sum l2_packet::calc_checksum computes for packet i.
+     *
+     * @param [in] i   - Index in the batch.
+     * @param [in] l3  - l3_sum(i).
+     */
+    uint32_t l2_sum(size_t i, uint32_t l3) const;
+};
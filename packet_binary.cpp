@@ -0,0 +1,188 @@
+#include "packet_binary.hpp"
+#include <cstring>
+#include <stdexcept>
+
+static void put_u16(std::string &out, uint16_t val) {
+    out.push_back(static_cast<char>(val & 0xFF));
+    out.push_back(static_cast<char>(val >> 8));
+}
+
+static void put_u32(std::string &out, uint32_t val) {
+    put_u16(out, static_cast<uint16_t>(val & 0xFFFF));
+    put_u16(out, static_cast<uint16_t>(val >> 16));
+}
+
+static void put_bytes(std::string &out, const uint8_t *bytes, size_t size) {
+    out.append(reinterpret_cast<const char *>(bytes), size);
+}
+
+// Packed addresses are stored as their bytes, first byte first
+static void put_ip(std::string &out, uint32_t addr) {
+    uint8_t ip[IP_V4_SIZE];
+    unpack_ipv4(addr, ip);
+    put_bytes(out, ip, IP_V4_SIZE);
+}
+
+static void put_mac(std::string &out, uint64_t addr) {
+    uint8_t mac[MAC_SIZE];
+    unpack_mac(addr, mac);
+    put_bytes(out, mac, MAC_SIZE);
+}
+
+static const uint8_t *get_bytes(const char *p) {
+    return reinterpret_cast<const uint8_t *>(p);
+}
+
+static uint16_t get_u16(const char *p) {
+    return static_cast<uint16_t>(static_cast<uint8_t>(p[0]) | (static_cast<uint8_t>(p[1]) << 8));
+}
+
+static uint32_t get_u32(const char *p) {
+    return get_u16(p) | (static_cast<uint32_t>(get_u16(p + 2)) << 16);
+}
+
+// Sizes of the fixed part of each layer
+static const size_t L2_FIXED_SIZE = 2 * MAC_SIZE + 2;
+static const size_t L3_FIXED_SIZE = 2 * IP_V4_SIZE + 1 + 2;
+static const size_t L4_FIXED_SIZE = 2 + 2 + 4 + 2;
+
+std::string binary_header() {
+    std::string header(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.push_back(static_cast<char>(BINARY_VERSION));
+    header.append(BINARY_HEADER_SIZE - header.size(), '\0');
+    return header;
+}
+
+bool is_binary_header(std::string_view bytes) {
+    return bytes.size() >= BINARY_HEADER_SIZE &&
+           std::memcmp(bytes.data(), BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0 &&
+           static_cast<uint8_t>(bytes[sizeof(BINARY_MAGIC)]) == BINARY_VERSION;
+}
+
+static bool put_l4(std::string &out, const l4_packet &pkt) {
+    if (pkt.data.size() > 0xFFFF) return false; // data_len is 16 bits
+    put_u16(out, pkt.src_port);
+    put_u16(out, pkt.dst_port);
+    put_u32(out, pkt.address);
+    put_u16(out, static_cast<uint16_t>(pkt.data.size()));
+    put_bytes(out, pkt.data.data(), pkt.data.size());
+    return true;
+}
+
+static bool put_l3(std::string &out, const l3_packet &pkt) {
+    put_ip(out, pkt.src_ip);
+    put_ip(out, pkt.dst_ip);
+    out.push_back(static_cast<char>(pkt.ttl));
+    put_u16(out, pkt.checksum);
+    return put_l4(out, pkt.payload);
+}
+
+packet_status text_to_binary(std::string_view line, std::string &record) {
+    packet_fields fields(line);
+    packet_layer layer = classify_packet(fields[0]);
+    if (layer == LAYER_INVALID) return PACKET_UNKNOWN_LAYER;
+    if (fields.size() != layer_field_count(layer)) return PACKET_BAD_FIELD_COUNT;
+
+    size_t start = record.size();
+    bool ok;
+    try {
+        record.push_back(static_cast<char>(layer));
+        if (layer == LAYER_L2) {
+            l2_packet pkt(fields, 0);
+            put_mac(record, pkt.src_mac);
+            put_mac(record, pkt.dst_mac);
+            put_u16(record, pkt.checksum);
+            ok = put_l3(record, pkt.payload);
+        } else if (layer == LAYER_L3) {
+            ok = put_l3(record, l3_packet(fields, 0));
+        } else {
+            ok = put_l4(record, l4_packet(fields, 0));
+        }
+    } catch (const std::invalid_argument &) {
+        ok = false;
+    }
+    if (!ok) {
+        record.resize(start);
+        return PACKET_MALFORMED;
+    }
+    return PACKET_OK;
+}
+
+/**
+ * @fn read_l4
+ * @brief Read the L4 part of a record into pkt.
+ */
+static bool read_l4(line_reader &fin, l4_packet &pkt) {
+    std::string_view bytes;
+    if (!fin.read(L4_FIXED_SIZE, bytes)) return false;
+    pkt.src_port = get_u16(bytes.data());
+    pkt.dst_port = get_u16(bytes.data() + 2);
+    pkt.address = get_u32(bytes.data() + 4);
+    size_t len = get_u16(bytes.data() + 8);
+    if (!fin.read(len, bytes)) return false;
+    pkt.data.assign(reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size());
+    return true;
+}
+
+/**
+ * @fn read_l3
+ * @brief Read the L3 and L4 parts of a record into pkt.
+ */
+static bool read_l3(line_reader &fin, l3_packet &pkt) {
+    std::string_view bytes;
+    if (!fin.read(L3_FIXED_SIZE, bytes)) return false;
+    pkt.src_ip = pack_ipv4(get_bytes(bytes.data()));
+    pkt.dst_ip = pack_ipv4(get_bytes(bytes.data() + IP_V4_SIZE));
+    pkt.ttl = static_cast<uint8_t>(bytes[2 * IP_V4_SIZE]);
+    pkt.checksum = get_u16(bytes.data() + 2 * IP_V4_SIZE + 1);
+    return read_l4(fin, pkt.payload);
+}
+
+packet_status read_binary_packet(line_reader &fin, packet_arena &arena, nic_packet *&pkt, packet_layer &layer) {
+    static const uint8_t zero[MAC_SIZE > IP_V4_SIZE ? MAC_SIZE : IP_V4_SIZE] = {};
+    pkt = nullptr;
+    layer = LAYER_INVALID;
+    std::string_view bytes;
+    if (!fin.read(1, bytes)) return PACKET_OK;
+
+    // Packets are built empty in the arena and their fields filled in place
+    auto empty_l4 = [&arena]() { return l4_packet(0, 0, 0, payload_buffer(&arena)); };
+    uint8_t kind = static_cast<uint8_t>(bytes[0]);
+    bool ok;
+    switch (kind) {
+    case LAYER_L2: {
+        l2_packet *l2 = arena.create<l2_packet>(zero, zero, 0, l3_packet(zero, zero, 0, 0, empty_l4()));
+        pkt = l2;
+        ok = fin.read(L2_FIXED_SIZE, bytes);
+        if (ok) {
+            l2->src_mac = pack_mac(get_bytes(bytes.data()));
+            l2->dst_mac = pack_mac(get_bytes(bytes.data() + MAC_SIZE));
+            l2->checksum = get_u16(bytes.data() + 2 * MAC_SIZE);
+            ok = read_l3(fin, l2->payload);
+        }
+        break;
+    }
+    case LAYER_L3: {
+        l3_packet *l3 = arena.create<l3_packet>(zero, zero, 0, 0, empty_l4());
+        pkt = l3;
+        ok = read_l3(fin, *l3);
+        break;
+    }
+    case LAYER_L4: {
+        l4_packet *l4 = arena.create<l4_packet>(empty_l4());
+        pkt = l4;
+        ok = read_l4(fin, *l4);
+        break;
+    }
+    default:
+        return PACKET_UNKNOWN_LAYER;
+    }
+
+    if (!ok) {
+        arena_deleter()(pkt);
+        pkt = nullptr;
+        return PACKET_MALFORMED;
+    }
+    layer = static_cast<packet_layer>(kind);
+    return PACKET_OK;
+}
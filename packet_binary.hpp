@@ -0,0 +1,80 @@
+#pragma once
+#include "L2.h"
+#include "L3.h"
+#include "L4.h"
+#include "line_reader.hpp"
+#include "packet_parser.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * Binary packet trace format
+ *
+ * A trace starts with an 8 byte header: the magic "NICB", a version byte
+ * and 3 reserved zero bytes. It is followed by one record per packet. All
+ * integers are little endian.
+ *
+ *     layer     u8      1 = L2, 2 = L3, 3 = L4
+ *   L2 only:
+ *     src_mac   u8[6]
+ *     dst_mac   u8[6]
+ *     checksum  u16
+ *   L2 and L3:
+ *     src_ip    u8[4]
+ *     dst_ip    u8[4]
+ *     ttl       u8
+ *     checksum  u16
+ *   All layers:
+ *     src_port  u16
+ *     dst_port  u16
+ *     address   u32
+ *     data_len  u16
+ *     data      u8[data_len]
+ */
+
+static const char BINARY_MAGIC[4] = {'N', 'I', 'C', 'B'};
+static const uint8_t BINARY_VERSION = 1;
+static const size_t BINARY_HEADER_SIZE = 8;
+
+/**
+ * @fn binary_header
+ * @brief Get the header every binary trace starts with.
+ */
+std::string binary_header();
+
+/**
+ * @fn is_binary_header
+ * @brief Check whether bytes hold a supported binary trace header.
+ *
+ * @param [in] bytes - First BINARY_HEADER_SIZE bytes of a file.
+ */
+bool is_binary_header(std::string_view bytes);
+
+/**
+ * @fn text_to_binary
+ * @brief Convert a text packet string to a binary record.
+ *
+ * @param [in] line    - String representation of a packet.
+ * @param [out] record - Appended with the binary record.
+ *
+ * @return PACKET_OK on success, the reason the string was rejected otherwise.
+ */
+packet_status text_to_binary(std::string_view line, std::string &record);
+
+/**
+ * @fn read_binary_packet
+ * @brief Read the next binary record and build the matching packet in
+ *        the arena.
+ *
+ * @param [in] fin   - Reader positioned at a record.
+ * @param [in] arena - Arena the packet and its data are allocated from.
+ * @param [out] pkt  - Pointer to the new packet, nullptr on failure.
+ * @param [out] layer - Layer of the new packet.
+ *
+ * @return PACKET_OK on success, PACKET_MALFORMED on a truncated or corrupt
+ *         record, PACKET_UNKNOWN_LAYER on a bad layer byte. At end of file
+ *         PACKET_OK is returned with pkt set to nullptr.
+ */
+packet_status read_binary_packet(line_reader &fin, packet_arena &arena, nic_packet *&pkt, packet_layer &layer);
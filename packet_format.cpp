@@ -0,0 +1,65 @@
+#include "packet_format.hpp"
+#include <charconv>
+
+/**
+ * @struct hex_table
+ * @brief The two lowercase hex digits of every byte value.
+ */
+struct hex_table {
+    char digits[256][2];
+
+    constexpr hex_table() : digits() {
+        const char hex[] = "0123456789abcdef";
+        for (int i = 0; i < 256; ++i) {
+            digits[i][0] = hex[i >> 4];
+            digits[i][1] = hex[i & 0xF];
+        }
+    }
+};
+
+static constexpr hex_table HEX;
+
+char *format_dec(char *out, uint32_t val) {
+    return std::to_chars(out, out + DEC_U32_MAX_SIZE, val).ptr;
+}
+
+char *format_ip(char *out, const uint8_t ip[IP_V4_SIZE]) {
+    for (int i = 0; i < IP_V4_SIZE; ++i) {
+        if (i) *out++ = '.';
+        out = format_dec(out, ip[i]);
+    }
+    return out;
+}
+
+char *format_ip(char *out, uint32_t ip) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        if (shift != 24) *out++ = '.';
+        out = format_dec(out, (ip >> shift) & 0xFF);
+    }
+    return out;
+}
+
+char *format_mac(char *out, const uint8_t mac[MAC_SIZE]) {
+    return format_hex_bytes(out, mac, MAC_SIZE, ':');
+}
+
+char *format_mac(char *out, uint64_t mac) {
+    for (int shift = 40; shift >= 0; shift -= 8) {
+        if (shift != 40) *out++ = ':';
+        uint8_t byte = static_cast<uint8_t>(mac >> shift);
+        out[0] = HEX.digits[byte][0];
+        out[1] = HEX.digits[byte][1];
+        out += 2;
+    }
+    return out;
+}
+
+char *format_hex_bytes(char *out, const uint8_t *data, size_t size, char sep) {
+    for (size_t i = 0; i < size; ++i) {
+        if (i) *out++ = sep;
+        out[0] = HEX.digits[data[i]][0];
+        out[1] = HEX.digits[data[i]][1];
+        out += 2;
+    }
+    return out;
+}
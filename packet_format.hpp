@@ -0,0 +1,82 @@
+#pragma once
+#include "packets.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Writers for the text form of packet fields. Each writes into a caller
+ * supplied buffer that is large enough and returns the end of what it
+ * wrote, so a whole packet is serialized without allocating or going
+ * through iostreams. The output is identical to the stream formatting the
+ * packets used before (lowercase, zero padded hex).
+ */
+
+static constexpr size_t DEC_U32_MAX_SIZE = 10;                  /**< Digits of a uint32_t */
+static constexpr size_t IP_STR_MAX_SIZE = 4 * IP_V4_SIZE - 1;   /**< "255.255.255.255" */
+static constexpr size_t MAC_STR_SIZE = 3 * MAC_SIZE - 1;        /**< "xx:xx:xx:xx:xx:xx" */
+
+/**
+ * @fn format_dec
+ * @brief Write a number in decimal.
+ *
+ * @param [out] out - Output buffer, at least DEC_U32_MAX_SIZE bytes.
+ * @param [in] val  - Value.
+ *
+ * @return End of the written text.
+ */
+char *format_dec(char *out, uint32_t val);
+
+/**
+ * @fn format_ip
+ * @brief Write a dotted decimal IPv4 address.
+ *
+ * @param [out] out - Output buffer, at least IP_STR_MAX_SIZE bytes.
+ * @param [in] ip   - IPv4 address.
+ *
+ * @return End of the written text.
+ */
+char *format_ip(char *out, const uint8_t ip[IP_V4_SIZE]);
+
+/**
+ * @fn format_ip
+ * @brief Write a dotted decimal IPv4 address packed by pack_ipv4.
+ */
+char *format_ip(char *out, uint32_t ip);
+
+/**
+ * @fn format_mac
+ * @brief Write a MAC address as xx:xx:xx:xx:xx:xx.
+ *
+ * @param [out] out - Output buffer, at least MAC_STR_SIZE bytes.
+ * @param [in] mac  - MAC address.
+ *
+ * @return End of the written text.
+ */
+char *format_mac(char *out, const uint8_t mac[MAC_SIZE]);
+
+/**
+ * @fn format_mac
+ * @brief Write a MAC address packed by pack_mac as xx:xx:xx:xx:xx:xx.
+ */
+char *format_mac(char *out, uint64_t mac);
+
+/**
+ * @fn format_hex_bytes
+ * @brief Write bytes as space separated two digit hex.
+ *
+ * @param [out] out  - Output buffer, at least hex_bytes_size(size) bytes.
+ * @param [in] data  - Bytes.
+ * @param [in] size  - Number of bytes.
+ * @param [in] sep   - Separator written between bytes.
+ *
+ * @return End of the written text.
+ */
+char *format_hex_bytes(char *out, const uint8_t *data, size_t size, char sep = ' ');
+
+/**
+ * @fn hex_bytes_size
+ * @brief Length of format_hex_bytes output for size bytes.
+ */
+inline size_t hex_bytes_size(size_t size) {
+    return size ? 3 * size - 1 : 0;
+}
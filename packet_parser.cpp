@@ -0,0 +1,165 @@
+#include "packet_parser.hpp"
+#include <charconv>
+
+static bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool is_hex_digit(char c) {
+    return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// Value of a lowercase hex digit
+static inline unsigned hex_value(char c) {
+    return c <= '9' ? c - '0' : c - 'a' + 10;
+}
+
+packet_layer classify_packet(std::string_view first_field) {
+    const size_t mac_len = 3 * MAC_SIZE - 1;
+    size_t len = first_field.size();
+    if (len == 0) return LAYER_INVALID;
+
+    // MAC address: hex pairs separated by ':'
+    if (len == mac_len && first_field[2] == ':') {
+        for (size_t i = 0; i < len; ++i) {
+            bool ok = (i % 3 == 2) ? first_field[i] == ':' : is_hex_digit(first_field[i]);
+            if (!ok) return LAYER_INVALID;
+        }
+        return LAYER_L2;
+    }
+
+    // IPv4 address (1-3 digits per byte) or a plain decimal port
+    int dots = 0, digits = 0;
+    for (char c : first_field) {
+        if (is_digit(c)) {
+            if (++digits > 3 && dots > 0) return LAYER_INVALID;
+        } else if (c == '.') {
+            if (digits == 0 || digits > 3 || ++dots > IP_V4_SIZE - 1) return LAYER_INVALID;
+            digits = 0;
+        } else {
+            return LAYER_INVALID;
+        }
+    }
+    if (dots == 0) return LAYER_L4;
+    return (dots == IP_V4_SIZE - 1 && digits > 0) ? LAYER_L3 : LAYER_INVALID;
+}
+
+size_t layer_field_count(packet_layer layer) {
+    switch (layer) {
+    case LAYER_L2: return 11; // src_mac|dst_mac|<L3 fields>|checksum
+    case LAYER_L3: return 8;  // src_ip|dst_ip|ttl|checksum|<L4 fields>
+    case LAYER_L4: return 4;  // src_port|dst_port|address|data
+    default:       return 0;
+    }
+}
+
+packet_fields::packet_fields(std::string_view str) : line(str), count(0) {
+    size_t pos = str.find('|');
+    while (pos != std::string_view::npos && count < MAX_FIELDS - 1) {
+        ends[count++] = pos;
+        pos = str.find('|', pos + 1);
+    }
+    ends[count++] = str.size();
+}
+
+std::string_view packet_fields::operator[](size_t i) const {
+    if (i >= count) return std::string_view();
+    size_t start = (i == 0) ? 0 : ends[i - 1] + 1;
+    return line.substr(start, ends[i] - start);
+}
+
+bool parse_dec(std::string_view str, long long &val) {
+    const char *first = str.data();
+    const char *last = first + str.size();
+    while (first != last && is_blank(*first)) ++first;
+    if (first != last && *first == '+') ++first;
+    return std::from_chars(first, last, val).ec == std::errc();
+}
+
+/**
+ * @fn parse_separated
+ * @brief Parse exactly count numbers in the given base separated by sep.
+ */
+static bool parse_separated(std::string_view str, char sep, int base, uint8_t *out, int count) {
+    const char *first = str.data();
+    const char *last = first + str.size();
+    for (int i = 0; i < count; ++i) {
+        unsigned long val;
+        auto res = std::from_chars(first, last, val, base);
+        if (res.ec != std::errc()) return false;
+        out[i] = static_cast<uint8_t>(val);
+        first = res.ptr;
+        if (i + 1 < count) {
+            if (first == last || *first != sep) return false;
+            ++first;
+        }
+    }
+    return true;
+}
+
+bool parse_mac(std::string_view str, uint8_t mac[MAC_SIZE]) {
+    return parse_separated(str, ':', 16, mac, MAC_SIZE);
+}
+
+bool parse_ip(std::string_view str, uint8_t ip[IP_V4_SIZE]) {
+    return parse_separated(str, '.', 10, ip, IP_V4_SIZE);
+}
+
+/**
+ * @fn parse_hex_token
+ * @brief Parse one blank-free token the way std::stoul(token, nullptr, 16)
+ *        does: an optional sign, an optional 0x/0X prefix, then hex digits
+ *        up to the first other character. A '-' negates modulo 2^64.
+ */
+static bool parse_hex_token(const char *first, const char *last, unsigned long &val) {
+    bool negative = false;
+    if (first != last && (*first == '+' || *first == '-')) negative = (*first++ == '-');
+    if (last - first > 2 && first[0] == '0' && (first[1] == 'x' || first[1] == 'X') && is_hex_digit(first[2]))
+        first += 2;
+    if (std::from_chars(first, last, val, 16).ec != std::errc()) return false;
+    if (negative) val = 0 - val;
+    return true;
+}
+
+bool parse_hex_bytes(std::string_view str, payload_buffer &data) {
+    const char *first = str.data();
+    const char *last = first + str.size();
+    data.reserve(data.size() + (str.size() + 1) / 3);
+    while (true) {
+        while (first != last && is_blank(*first)) ++first;
+        if (first == last) return true;
+        const char *end = first;
+        while (end != last && !is_blank(*end)) ++end;
+        unsigned long val;
+        if (!parse_hex_token(first, end, val)) return false;
+        data.push_back(static_cast<uint8_t>(val));
+        first = end;
+    }
+}
+
+bool is_canonical_hex(std::string_view str) {
+    if (str.empty()) return true;
+    if (str.size() % 3 != 2) return false;
+    for (size_t i = 0; i < str.size(); ++i) {
+        char c = str[i];
+        bool ok = (i % 3 == 2) ? c == ' ' : (is_digit(c) || (c >= 'a' && c <= 'f'));
+        if (!ok) return false;
+    }
+    return true;
+}
+
+void decode_canonical_hex(std::string_view str, uint8_t *out) {
+    for (size_t i = 0; i + 1 < str.size(); i += 3)
+        *out++ = static_cast<uint8_t>(hex_value(str[i]) << 4 | hex_value(str[i + 1]));
+}
+
+uint16_t canonical_hex_checksum(std::string_view str) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < str.size(); i += 3)
+        sum += hex_value(str[i]) << 4 | hex_value(str[i + 1]);
+    return static_cast<uint16_t>(sum);
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include "packets.hpp"
+#include "payload_buffer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * @enum packet_layer
+ * @brief Layer of a packet string, detected from the shape of its first field.
+ */
+enum packet_layer {
+    LAYER_INVALID, /**< First field matches no known layer */
+    LAYER_L2,      /**< First field is a MAC address */
+    LAYER_L3,      /**< First field is an IPv4 address */
+    LAYER_L4       /**< First field is a decimal port */
+};
+
+/**
+ * @enum packet_status
+ * @brief Result of turning a packet string into a packet object.
+ */
+enum packet_status {
+    PACKET_OK,             /**< Packet was created */
+    PACKET_UNKNOWN_LAYER,  /**< First field is not a MAC, IP or port */
+    PACKET_BAD_FIELD_COUNT,/**< Wrong number of fields for the detected layer */
+    PACKET_MALFORMED,      /**< A field could not be parsed */
+    PACKET_FILTERED        /**< Dropped by a header check before being built */
+};
+
+/**
+ * @class packet_fields
+ * @brief Single-pass tokenizer for '|'-delimited packet strings.
+ *
+ * All delimiter positions are located once per line and every layer reads
+ * its fields as views into the original string, so tokenizing allocates
+ * nothing. The last field always extends to the end of the line.
+ */
+class packet_fields {
+public:
+    static constexpr size_t MAX_FIELDS = 16; /**< Upper bound on fields per line */
+
+    /**
+     * @fn packet_fields
+     * @brief Tokenize a packet line.
+     *
+     * @param [in] str - Packet string. Must outlive this object.
+     */
+    explicit packet_fields(std::string_view str);
+
+    /**
+     * @fn size
+     * @brief Number of fields found in the line.
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @fn operator[]
+     * @brief Get a field by index.
+     *
+     * @param [in] i - Field index.
+     *
+     * @return View of the field, or an empty view if i is out of range.
+     */
+    std::string_view operator[](size_t i) const;
+
+private:
+    std::string_view line;          /**< Tokenized line */
+    size_t ends[MAX_FIELDS];        /**< End offset of every field */
+    size_t count;                   /**< Number of fields */
+};
+
+/**
+ * @fn classify_packet
+ * @brief Detect the layer of a packet from its first field in a single pass.
+ *
+ *        L2 - XX:XX:XX:XX:XX:XX (hexadecimal)
+ *        L3 - X.X.X.X (1-3 decimal digits per byte)
+ *        L4 - decimal number
+ *
+ * @param [in] first_field - First field of the packet string.
+ *
+ * @return The detected layer, LAYER_INVALID if none matches.
+ */
+packet_layer classify_packet(std::string_view first_field);
+
+/**
+ * @fn layer_field_count
+ * @brief Number of '|'-delimited fields a packet string of the layer has.
+ *
+ * @param [in] layer - Packet layer.
+ *
+ * @return The field count, 0 for LAYER_INVALID.
+ */
+size_t layer_field_count(packet_layer layer);
+
+/**
+ * @fn parse_dec
+ * @brief Parse a decimal field the way std::stoi does (leading blanks and a
+ *        sign are accepted, trailing characters are ignored).
+ *
+ * @param [in] str  - Field text.
+ * @param [out] val - Parsed value.
+ *
+ * @return true on success, false if the field holds no number.
+ */
+bool parse_dec(std::string_view str, long long &val);
+
+/**
+ * @fn parse_mac
+ * @brief Parse a MAC address of the form XX:XX:XX:XX:XX:XX.
+ *
+ * @param [in] str  - Field text.
+ * @param [out] mac - Parsed MAC address.
+ *
+ * @return true on success, false on malformed input.
+ */
+bool parse_mac(std::string_view str, uint8_t mac[MAC_SIZE]);
+
+/**
+ * @fn parse_ip
+ * @brief Parse a dotted decimal IPv4 address.
+ *
+ * @param [in] str - Field text.
+ * @param [out] ip - Parsed IPv4 address.
+ *
+ * @return true on success, false on malformed input.
+ */
+bool parse_ip(std::string_view str, uint8_t ip[IP_V4_SIZE]);
+
+/**
+ * @fn parse_hex_bytes
+ * @brief Parse whitespace separated hex bytes, appending them to data.
+ *
+ * Each token is read like std::stoul(token, nullptr, 16): an optional
+ * sign and 0x prefix are accepted, anything after the hex digits is
+ * ignored, and the value is truncated to 8 bits. A token without hex
+ * digits, or whose value does not fit an unsigned long, is malformed.
+ *
+ * @param [in] str   - Field text.
+ * @param [out] data - Output buffer.
+ *
+ * @return true on success, false on malformed input.
+ */
+bool parse_hex_bytes(std::string_view str, payload_buffer &data);
+
+/**
+ * @fn is_canonical_hex
+ * @brief Check whether hex bytes are written exactly the way packets
+ *        serialize them: two lowercase digits per byte, separated by single
+ *        spaces, nothing else.
+ *
+ * @param [in] str - Field text.
+ *
+ * @return true if str is canonical (the empty string is).
+ */
+bool is_canonical_hex(std::string_view str);
+
+/**
+ * @fn decode_canonical_hex
+ * @brief Decode canonical hex bytes (see is_canonical_hex).
+ *
+ * @param [in] str  - Canonical field text.
+ * @param [out] out - Output, (str.size() + 1) / 3 bytes.
+ */
+void decode_canonical_hex(std::string_view str, uint8_t *out);
+
+/**
+ * @fn canonical_hex_checksum
+ * @brief Sum canonical hex bytes mod 2^16 without decoding them to memory
+ *        (same result as bytes_checksum on the decoded bytes).
+ *
+ * @param [in] str - Canonical field text.
+ *
+ * @return The byte sum truncated to 16 bits.
+ */
+uint16_t canonical_hex_checksum(std::string_view str);
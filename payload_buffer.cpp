@@ -0,0 +1,56 @@
+#include "payload_buffer.hpp"
+#include <algorithm>
+
+payload_buffer::payload_buffer(const payload_buffer &other) : payload_buffer(std::pmr::get_default_resource()) {
+    assign(other.data(), other.len);
+}
+
+payload_buffer::payload_buffer(payload_buffer &&other) noexcept
+    : mem(other.mem), len(other.len), cap(other.cap) {
+    if (cap > INLINE_SIZE) {
+        heap = other.heap;
+        other.cap = INLINE_SIZE;
+    } else {
+        std::memcpy(local, other.local, len);
+    }
+    other.len = 0;
+}
+
+payload_buffer &payload_buffer::operator=(const payload_buffer &other) {
+    if (this != &other) assign(other.data(), other.len);
+    return *this;
+}
+
+payload_buffer &payload_buffer::operator=(payload_buffer &&other) noexcept {
+    if (this == &other) return *this;
+    if (other.cap > INLINE_SIZE && other.mem == mem) {
+        // Take over the other buffer's storage
+        release();
+        heap = other.heap;
+        cap = other.cap;
+        len = other.len;
+        other.cap = INLINE_SIZE;
+    } else {
+        assign(other.data(), other.len);
+    }
+    other.len = 0;
+    return *this;
+}
+
+payload_buffer::~payload_buffer() {
+    release();
+}
+
+void payload_buffer::grow(size_t size) {
+    size_t new_cap = std::max<size_t>(size, 2 * static_cast<size_t>(cap));
+    uint8_t *bytes = static_cast<uint8_t *>(mem->allocate(new_cap, 1));
+    std::memcpy(bytes, data(), len);
+    release();
+    heap = bytes;
+    cap = static_cast<uint32_t>(new_cap);
+}
+
+void payload_buffer::release() {
+    if (cap > INLINE_SIZE) mem->deallocate(heap, cap, 1);
+    cap = INLINE_SIZE;
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include "common.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+
+/**
+ * @class payload_buffer
+ * @brief Byte buffer for L4 data with inline room for DATA_ARR_SIZE bytes.
+ *
+ * Data that fits in LOCAL DRAM is stored inside the buffer itself, so
+ * building a packet does not allocate and copying one is a memcpy. Longer
+ * data (which can still be forwarded to RQ/TQ) moves to storage allocated
+ * from the buffer's memory resource, in place of the inline bytes.
+ */
+class payload_buffer {
+public:
+    static constexpr size_t INLINE_SIZE = DATA_ARR_SIZE; /**< Bytes stored inline */
+
+    /**
+     * @fn payload_buffer
+     * @brief Construct an empty buffer.
+     *
+     * @param [in] mem - Memory resource for data longer than INLINE_SIZE.
+     */
+    explicit payload_buffer(std::pmr::memory_resource *mem = std::pmr::get_default_resource())
+        : mem(mem), len(0), cap(INLINE_SIZE) {}
+
+    /**
+     * @fn payload_buffer
+     * @brief Construct a buffer holding a copy of some bytes.
+     *
+     * @param [in] bytes - Bytes to copy.
+     * @param [in] size  - Number of bytes.
+     * @param [in] mem   - Memory resource for data longer than INLINE_SIZE.
+     */
+    payload_buffer(const uint8_t *bytes, size_t size,
+                   std::pmr::memory_resource *mem = std::pmr::get_default_resource())
+        : payload_buffer(mem) {
+        assign(bytes, size);
+    }
+
+    /**
+     * @fn payload_buffer
+     * @brief Copy a buffer. Long data of the copy is allocated from the
+     *        default resource, so the copy does not depend on the lifetime
+     *        of the original's resource (e.g. an arena that gets reset).
+     *
+     * @param [in] other - Buffer to copy.
+     */
+    payload_buffer(const payload_buffer &other);
+    payload_buffer(payload_buffer &&other) noexcept;
+    payload_buffer &operator=(const payload_buffer &other);
+    payload_buffer &operator=(payload_buffer &&other) noexcept;
+    ~payload_buffer();
+
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    uint8_t *data() { return cap > INLINE_SIZE ? heap : local; }
+    const uint8_t *data() const { return cap > INLINE_SIZE ? heap : local; }
+    uint8_t &operator[](size_t i) { return data()[i]; }
+    const uint8_t &operator[](size_t i) const { return data()[i]; }
+    const uint8_t *begin() const { return data(); }
+    const uint8_t *end() const { return data() + len; }
+
+    /**
+     * @fn clear
+     * @brief Remove all bytes, keeping the storage.
+     */
+    void clear() { len = 0; }
+
+    /**
+     * @fn reserve
+     * @brief Make room for size bytes.
+     */
+    void reserve(size_t size) {
+        if (size > cap) grow(size);
+    }
+
+    /**
+     * @fn resize
+     * @brief Set the number of bytes, new bytes are zero.
+     */
+    void resize(size_t size) {
+        reserve(size);
+        if (size > len) std::memset(data() + len, 0, size - len);
+        len = static_cast<uint32_t>(size);
+    }
+
+    /**
+     * @fn push_back
+     * @brief Append a byte.
+     */
+    void push_back(uint8_t byte) {
+        if (len == cap) grow(len + 1);
+        data()[len++] = byte;
+    }
+
+    /**
+     * @fn assign
+     * @brief Replace the contents with a copy of some bytes.
+     */
+    void assign(const uint8_t *bytes, size_t size) {
+        len = 0;
+        reserve(size);
+        if (size) std::memcpy(data(), bytes, size);
+        len = static_cast<uint32_t>(size);
+    }
+
+    /**
+     * @fn resource
+     * @brief Memory resource of data longer than INLINE_SIZE.
+     */
+    std::pmr::memory_resource *resource() const { return mem; }
+
+private:
+    /**
+     * @fn grow
+     * @brief Move the bytes to allocated storage of at least size bytes.
+     */
+    void grow(size_t size);
+
+    /**
+     * @fn release
+     * @brief Free the allocated storage, if any, and go back to inline.
+     */
+    void release();
+
+    union {
+        uint8_t local[INLINE_SIZE];     /**< Inline bytes, while cap == INLINE_SIZE */
+        uint8_t *heap;                  /**< Allocated bytes, while cap > INLINE_SIZE */
+    };
+    std::pmr::memory_resource *mem;     /**< Resource heap comes from */
+    uint32_t len;                       /**< Number of bytes */
+    uint32_t cap;                       /**< Bytes available in local or heap */
+
+    static_assert(INLINE_SIZE >= sizeof(uint8_t *), "inline bytes must cover the heap pointer");
+};
@@ -0,0 +1,51 @@
+/**
+ * @file pkt2bin.cpp
+ * @brief Convert a text packet file to the binary trace format read by
+ *        nic_sim::nic_flow (see packet_binary.hpp).
+ *
+ * Usage: pkt2bin.exe <packet_file|-> <binary_file>
+ *
+ * Lines that are not valid packets are reported on stderr and skipped.
+ */
+
+#include "packet_binary.hpp"
+#include "line_reader.hpp"
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <packet_file|-> <binary_file>" << std::endl;
+        return 1;
+    }
+
+    line_reader fin(argv[1]);
+    if (!fin.is_open()) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+    std::ofstream fout(argv[2], std::ios::binary);
+    if (!fout) {
+        std::cerr << "Cannot open " << argv[2] << std::endl;
+        return 1;
+    }
+
+    fout << binary_header();
+    std::string record;
+    std::string_view line;
+    size_t line_no = 0;
+    while (fin.next(line)) {
+        ++line_no;
+        if (line.empty()) continue;
+        record.clear();
+        packet_status status = text_to_binary(line, record);
+        if (status != PACKET_OK) {
+            std::cerr << "Line " << line_no << ": skipped (error " << status << ")" << std::endl;
+            continue;
+        }
+        fout.write(record.data(), record.size());
+        fin.release();
+    }
+    return fout ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#include "port_table.hpp"
+
+open_port_table::open_port_table() : shift(32) {}
+
+open_port_table::open_port_table(const open_port_vec &open_ports) : shift(32) {
+    build(open_ports);
+}
+
+void open_port_table::build(const open_port_vec &open_ports) {
+    slots.clear();
+    if (open_ports.empty()) {
+        shift = 32;
+        return;
+    }
+
+    // Keep the load factor at or below 1/2
+    uint32_t bits = 1;
+    while ((static_cast<size_t>(1) << bits) < 2 * open_ports.size()) ++bits;
+    shift = 32 - bits;
+    slots.assign(static_cast<size_t>(1) << bits, slot{0, -1});
+
+    uint32_t mask = static_cast<uint32_t>(slots.size() - 1);
+    for (size_t i = 0; i < open_ports.size(); ++i) {
+        uint32_t key = make_key(open_ports[i].src_prt, open_ports[i].dst_prt);
+        uint32_t pos = slot_of(key);
+        while (slots[pos].index != -1 && slots[pos].key != key) pos = (pos + 1) & mask;
+        // Duplicate pairs keep the first entry, as a linear scan would find it
+        if (slots[pos].index == -1) slots[pos] = slot{key, static_cast<int32_t>(i)};
+    }
+}
+
+int open_port_table::scan(const open_port_vec &open_ports, uint16_t src_prt, uint16_t dst_prt) {
+    for (size_t i = 0; i < open_ports.size(); ++i) {
+        if (open_ports[i].src_prt == src_prt && open_ports[i].dst_prt == dst_prt) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+int open_port_table::find(uint16_t src_prt, uint16_t dst_prt) const {
+    if (slots.empty()) return -1;
+    uint32_t key = make_key(src_prt, dst_prt);
+    uint32_t mask = static_cast<uint32_t>(slots.size() - 1);
+    for (uint32_t pos = slot_of(key); slots[pos].index != -1; pos = (pos + 1) & mask) {
+        if (slots[pos].key == key) return slots[pos].index;
+    }
+    return -1;
+}
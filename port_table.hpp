@@ -0,0 +1,90 @@
+#pragma once
+#include "packets.hpp"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class open_port_table
+ * @brief Hash index over the NIC's open ports.
+ *
+ * Maps a (src_prt, dst_prt) pair, packed into a 32-bit key, to its position
+ * in the open_port_vec it was built from. Uses a flat open-addressing table
+ * with linear probing, so a lookup costs O(1) regardless of the number of
+ * open ports. The vector itself is left untouched, so its order (and thus
+ * the LOCAL DRAM print order) is preserved.
+ */
+class open_port_table {
+public:
+    /**
+     * @fn open_port_table
+     * @brief Construct an empty table.
+     */
+    open_port_table();
+
+    /**
+     * @fn open_port_table
+     * @brief Construct a table indexing the given ports.
+     *
+     * @param [in] open_ports - Vector containing all the NIC's open ports.
+     */
+    explicit open_port_table(const open_port_vec &open_ports);
+
+    /**
+     * @fn build
+     * @brief Rebuild the table to index the given ports.
+     *
+     * @param [in] open_ports - Vector containing all the NIC's open ports.
+     */
+    void build(const open_port_vec &open_ports);
+
+    /**
+     * @fn find
+     * @brief Look up an open port.
+     *
+     * @param [in] src_prt - Source port.
+     * @param [in] dst_prt - Destination port.
+     *
+     * @return Index of the first matching port in open_port_vec, -1 if none.
+     */
+    int find(uint16_t src_prt, uint16_t dst_prt) const;
+
+    /**
+     * @fn scan
+     * @brief Look up an open port without an index, by a linear scan.
+     *
+     * For callers holding only the vector, where building a table for a
+     * single lookup would cost more than the scan.
+     *
+     * @param [in] open_ports - Vector containing all the NIC's open ports.
+     * @param [in] src_prt    - Source port.
+     * @param [in] dst_prt    - Destination port.
+     *
+     * @return Index of the first matching port in open_port_vec, -1 if none.
+     */
+    static int scan(const open_port_vec &open_ports, uint16_t src_prt, uint16_t dst_prt);
+
+    /**
+     * @fn make_key
+     * @brief Pack a port pair into a single 32-bit key.
+     */
+    static uint32_t make_key(uint16_t src_prt, uint16_t dst_prt) {
+        return (static_cast<uint32_t>(src_prt) << 16) | dst_prt;
+    }
+
+private:
+    struct slot {
+        uint32_t key;   /**< Packed port pair */
+        int32_t index;  /**< Index in open_port_vec, -1 for an empty slot */
+    };
+
+    /**
+     * @fn slot_of
+     * @brief Home slot of a key (multiplicative hashing).
+     */
+    uint32_t slot_of(uint32_t key) const {
+        return (key * 0x9E3779B1u) >> shift;
+    }
+
+    std::vector<slot> slots;  /**< Power of two sized slot array */
+    uint32_t shift;           /**< 32 - log2(slots.size()) */
+};
@@ -0,0 +1,89 @@
+#include "queue_sink.hpp"
+#include <algorithm>
+
+void memory_sink::push(std::string_view packet) {
+    packets.emplace_back(packet);
+}
+
+void memory_sink::print(fd_writer &out) {
+    for (const auto& pkt : packets) {
+        out.append(pkt);
+        out.append("\n");
+    }
+}
+
+stream_sink::stream_sink(std::ostream &out) : out(out) {}
+
+stream_sink::stream_sink(const std::string &file_name) : file(file_name), out(file) {}
+
+void stream_sink::push(std::string_view packet) {
+    out << packet << '\n';
+}
+
+void stream_sink::print(fd_writer &) {
+    out.flush();
+}
+
+ring_sink::ring_sink(std::ostream &out, size_t capacity)
+    : out(&out), slots(std::max<size_t>(capacity, 1)), head(0), count(0),
+      stopping(false), writer(&ring_sink::writer_main, this) {}
+
+ring_sink::ring_sink(size_t capacity)
+    : out(nullptr), slots(std::max<size_t>(capacity, 1)), head(0), count(0), stopping(false) {}
+
+ring_sink::~ring_sink() {
+    if (!out) return;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    not_empty.notify_one();
+    writer.join();
+    out->flush();
+}
+
+void ring_sink::push(std::string_view packet) {
+    std::unique_lock<std::mutex> guard(lock);
+    if (!out && count == slots.size()) {
+        // Keeping the last packets: overwrite the oldest
+        slots[head].assign(packet.data(), packet.size());
+        head = (head + 1) % slots.size();
+        return;
+    }
+    not_full.wait(guard, [this] { return count < slots.size(); });
+    slots[(head + count) % slots.size()].assign(packet.data(), packet.size());
+    ++count;
+    guard.unlock();
+    if (out) not_empty.notify_one();
+}
+
+void ring_sink::print(fd_writer &dump) {
+    std::unique_lock<std::mutex> guard(lock);
+    if (!out) {
+        for (size_t i = 0; i < count; ++i) {
+            dump.append(slots[(head + i) % slots.size()]);
+            dump.append("\n");
+        }
+        return;
+    }
+    not_full.wait(guard, [this] { return count == 0; });
+    out->flush();
+}
+
+void ring_sink::writer_main() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        not_empty.wait(guard, [this] { return stopping || count > 0; });
+        if (count == 0) return;
+
+        // Write the head slot outside the lock; push() never touches it
+        std::string &slot = slots[head];
+        guard.unlock();
+        *out << slot << '\n';
+        guard.lock();
+
+        head = (head + 1) % slots.size();
+        --count;
+        not_full.notify_all();
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include "fd_writer.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * @class queue_sink
+ * @brief Destination of the packets the NIC forwards to RQ or TQ.
+ */
+class queue_sink {
+public:
+    virtual ~queue_sink() = default;
+
+    /**
+     * @fn push
+     * @brief Append a packet to the queue.
+     *
+     * @param [in] packet - String representation of the packet.
+     */
+    virtual void push(std::string_view packet) = 0;
+
+    /**
+     * @fn print
+     * @brief Print the packets the queue still holds, one per line, through
+     *        a buffered writer.
+     *
+     * @param [in] out - Output writer.
+     */
+    virtual void print(fd_writer &out) = 0;
+};
+
+/**
+ * @class memory_sink
+ * @brief Keeps every packet in memory until it is printed (default).
+ */
+class memory_sink : public queue_sink {
+public:
+    void push(std::string_view packet) override;
+    void print(fd_writer &out) override;
+
+private:
+    std::vector<std::string> packets;
+};
+
+/**
+ * @class stream_sink
+ * @brief Writes every packet to a stream as soon as it is produced.
+ *
+ * Nothing is kept in memory, so print() only flushes the stream.
+ */
+class stream_sink : public queue_sink {
+public:
+    /**
+     * @fn stream_sink
+     * @brief Stream packets to an existing stream (e.g. std::cout).
+     *
+     * @param [in] out - Output stream, must outlive the sink.
+     */
+    explicit stream_sink(std::ostream &out);
+
+    /**
+     * @fn stream_sink
+     * @brief Stream packets to a file.
+     *
+     * @param [in] file_name - Output file name, truncated on open.
+     */
+    explicit stream_sink(const std::string &file_name);
+
+    void push(std::string_view packet) override;
+    void print(fd_writer &out) override;
+
+private:
+    std::ofstream file;
+    std::ostream &out;
+};
+
+/**
+ * @class ring_sink
+ * @brief Bounded ring buffer of packets.
+ *
+ * Drained to a stream, a writer thread writes the packets out in order and
+ * push() blocks while the ring is full, so a slow output applies
+ * backpressure to the simulation instead of growing memory. Without a
+ * stream the ring keeps the last packets only: a push into a full ring
+ * drops the oldest one, and print() writes what is left. Slot strings are
+ * reused, so steady state pushes do not allocate.
+ */
+class ring_sink : public queue_sink {
+public:
+    /**
+     * @fn ring_sink
+     * @brief Start the writer thread.
+     *
+     * @param [in] out      - Output stream, must outlive the sink.
+     * @param [in] capacity - Number of packets the ring holds (at least 1).
+     */
+    ring_sink(std::ostream &out, size_t capacity);
+
+    /**
+     * @fn ring_sink
+     * @brief Keep the last packets in memory, without a writer thread.
+     *
+     * @param [in] capacity - Number of packets kept (at least 1).
+     */
+    explicit ring_sink(size_t capacity);
+
+    /**
+     * @fn ~ring_sink
+     * @brief Drain the ring and stop the writer thread.
+     */
+    ~ring_sink() override;
+
+    void push(std::string_view packet) override;
+    void print(fd_writer &out) override;
+
+private:
+    /**
+     * @fn writer_main
+     * @brief Writer thread body.
+     */
+    void writer_main();
+
+    std::ostream *out;  /**< Drained to, nullptr when keeping the last packets */
+    std::vector<std::string> slots;
+    size_t head;    /**< Oldest slot, the next one to write out */
+    size_t count;   /**< Slots in use */
+    bool stopping;
+    std::mutex lock;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::thread writer;
+};
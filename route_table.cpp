@@ -0,0 +1,55 @@
+#include "route_table.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+static uint32_t length_netmask(uint8_t length) {
+    return length == 0 ? 0 : 0xFFFFFFFFu << (32 - length);
+}
+
+route_table::route_table() {}
+
+void route_table::add(uint32_t prefix, uint8_t length, route_action action) {
+    if (length > 32) length = 32;
+    routes.push_back(route{prefix & length_netmask(length), length, action});
+}
+
+size_t route_table::expand(std::vector<uint16_t> &table, size_t at) {
+    uint16_t entry = table[at];
+    if (entry & GROUP) return static_cast<size_t>(entry & ~GROUP) << 8;
+
+    size_t group = tbl8.size() >> 8;
+    if (group >= GROUP) throw std::length_error("route_table: too many long prefixes");
+    tbl8.insert(tbl8.end(), 256, entry);
+    table[at] = static_cast<uint16_t>(GROUP | group);
+    return group << 8;
+}
+
+void route_table::build() {
+    tbl16.clear();
+    tbl8.clear();
+    if (routes.empty()) return;
+    tbl16.assign(static_cast<size_t>(1) << 16, ACTION_NONE);
+
+    // Paint shorter prefixes first so longer ones overwrite them. Groups are
+    // only created for prefixes longer than their level, after every shorter
+    // prefix covering them is painted, so they inherit the right action.
+    std::vector<route> sorted = routes;
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const route &a, const route &b) { return a.length < b.length; });
+
+    for (const auto &r : sorted) {
+        if (r.length <= 16) {
+            size_t first = r.prefix >> 16;
+            std::fill_n(tbl16.begin() + first, static_cast<size_t>(1) << (16 - r.length), r.action);
+            continue;
+        }
+        size_t group = expand(tbl16, r.prefix >> 16);
+        size_t at = group | ((r.prefix >> 8) & 0xFF);
+        if (r.length <= 24) {
+            std::fill_n(tbl8.begin() + at, static_cast<size_t>(1) << (24 - r.length), r.action);
+            continue;
+        }
+        group = expand(tbl8, at);
+        std::fill_n(tbl8.begin() + (group | (r.prefix & 0xFF)), static_cast<size_t>(1) << (32 - r.length), r.action);
+    }
+}
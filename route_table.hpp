@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @enum route_action
+ * @brief What a routing table prefix does with the packets sent to it.
+ */
+enum route_action : uint8_t {
+    ACTION_NONE,   /**< No prefix matched */
+    ACTION_NET,    /**< The NIC's own network: classify by source/destination */
+    ACTION_RQ,     /**< Forward to RQ */
+    ACTION_TQ,     /**< Forward to TQ */
+    ACTION_DROP    /**< Drop the packet */
+};
+
+/**
+ * @class route_table
+ * @brief Longest-prefix-match table over packed IPv4 addresses.
+ *
+ * Prefixes are added, then build() expands them into a DIR-16-8-8 table:
+ * a 2^16 entry first level indexed by the top 16 address bits, whose
+ * entries either hold the action directly or point to a 256 entry group
+ * for the next 8 bits (and again for the last 8). A lookup is at most
+ * three dependent loads and no comparisons, whatever the number of
+ * prefixes.
+ */
+class route_table {
+public:
+    /**
+     * @fn route_table
+     * @brief Construct an empty table.
+     */
+    route_table();
+
+    /**
+     * @fn add
+     * @brief Add a prefix. Takes effect on the next build().
+     *
+     * @param [in] prefix - Prefix address, packed by pack_ipv4.
+     * @param [in] length - Prefix length, 0-32.
+     * @param [in] action - Action of the prefix. For equal prefixes the
+     *                      one added last wins.
+     */
+    void add(uint32_t prefix, uint8_t length, route_action action);
+
+    /**
+     * @fn build
+     * @brief Build the lookup table from the added prefixes.
+     *
+     * @throw std::length_error if the prefixes need more than 32767 groups.
+     */
+    void build();
+
+    /**
+     * @fn size
+     * @brief Number of added prefixes.
+     */
+    size_t size() const { return routes.size(); }
+
+    /**
+     * @fn lookup
+     * @brief Find the action of the longest prefix matching an address.
+     *
+     * @param [in] addr - Address, packed by pack_ipv4.
+     *
+     * @return The action, ACTION_NONE if no prefix matches.
+     */
+    route_action lookup(uint32_t addr) const {
+        if (tbl16.empty()) return ACTION_NONE;
+        uint16_t entry = tbl16[addr >> 16];
+        if (entry & GROUP) {
+            entry = tbl8[(static_cast<size_t>(entry & ~GROUP) << 8) | ((addr >> 8) & 0xFF)];
+            if (entry & GROUP) entry = tbl8[(static_cast<size_t>(entry & ~GROUP) << 8) | (addr & 0xFF)];
+        }
+        return static_cast<route_action>(entry);
+    }
+
+private:
+    static constexpr uint16_t GROUP = 0x8000;  /**< Entry points to a tbl8 group */
+
+    struct route {
+        uint32_t prefix;       /**< Prefix address, host bits cleared */
+        uint8_t length;        /**< Prefix length */
+        route_action action;   /**< Action of the prefix */
+    };
+
+    /**
+     * @fn expand
+     * @brief Turn a table entry into a group pointer, filling the new group
+     *        with the entry's previous action.
+     *
+     * @param [in] table - tbl16 or tbl8.
+     * @param [in] at    - Index of the entry in table.
+     *
+     * @return Index of the group's first entry in tbl8.
+     */
+    size_t expand(std::vector<uint16_t> &table, size_t at);
+
+    std::vector<route> routes;     /**< Added prefixes */
+    std::vector<uint16_t> tbl16;   /**< First level, empty before build() */
+    std::vector<uint16_t> tbl8;    /**< 256 entry groups */
+};
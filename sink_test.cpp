@@ -0,0 +1,196 @@
+/**
+ * @file sink_test.cpp
+ * @brief Checks of the RQ/TQ queue sinks.
+ *
+ * Usage: sink_test.exe [packets] [seed]
+ *
+ * ring_sink on its own: without a stream it keeps the last N packets in
+ * order, and drained to a stream through a small ring it loses none. Then
+ * nic_sim runs a generated trace (see trace_gen.hpp) once per sink, and
+ * each run must reproduce the default memory_sink dump: stream_sink output
+ * placed under the RQ/TQ headers of nic_print_results, the output of a
+ * ring_sink drained to a stream, and a ring_sink keeping the last N
+ * packets, which must hold the tail of each queue.
+ */
+
+#include "NIC_sim.hpp"
+#include "trace_gen.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+static size_t failures = 0;
+
+/**
+ * @fn check
+ * @brief Report a failed check.
+ */
+static void check(bool ok, const std::string &what) {
+    if (ok) return;
+    std::cerr << "sink_test: " << what << std::endl;
+    ++failures;
+}
+
+/**
+ * @fn capture
+ * @brief Everything a callback writes to the file descriptor it is given.
+ */
+static std::string capture(const std::function<void(int)> &write) {
+    FILE *file = std::tmpfile();
+    write(fileno(file));
+    std::rewind(file);
+    std::string text;
+    char buf[4096];
+    for (size_t n; (n = std::fread(buf, 1, sizeof(buf), file)) > 0; ) text.append(buf, n);
+    std::fclose(file);
+    return text;
+}
+
+/**
+ * @fn numbered
+ * @brief Packet lines "packet <first>" to "packet <last>", one per line.
+ */
+static std::string numbered(int first, int last) {
+    std::string text;
+    for (int i = first; i <= last; ++i) text += "packet " + std::to_string(i) + "\n";
+    return text;
+}
+
+/**
+ * @fn last_lines
+ * @brief The last n lines of a text made of whole lines.
+ */
+static std::string last_lines(const std::string &text, size_t n) {
+    size_t pos = text.size();
+    while (n-- > 0 && pos > 0) {
+        size_t prev = pos >= 2 ? text.rfind('\n', pos - 2) : std::string::npos;
+        pos = (prev == std::string::npos) ? 0 : prev + 1;
+    }
+    return text.substr(pos);
+}
+
+/**
+ * @struct results
+ * @brief A nic_print_results dump split into its sections.
+ */
+struct results {
+    std::string dram;   /**< "LOCAL DRAM:" section, up to the RQ header */
+    std::string rq;     /**< RQ packet lines */
+    std::string tq;     /**< TQ packet lines */
+
+    explicit results(const std::string &dump) {
+        size_t rq_pos = dump.find("\n\nRQ:\n") + 2;
+        size_t tq_pos = dump.find("\n\nTQ:\n", rq_pos - 1);
+        dram = dump.substr(0, rq_pos);
+        rq = dump.substr(rq_pos + 4, tq_pos + 1 - (rq_pos + 4));
+        tq = dump.substr(tq_pos + 6);
+    }
+
+    std::string joined() const {
+        return dram + "RQ:\n" + rq + "\nTQ:\n" + tq;
+    }
+};
+
+/**
+ * @fn run_sim
+ * @brief Run nic_sim on a trace with the given sinks and return the
+ *        nic_print_results dump.
+ *
+ * @param [in] param_file  - Parameter file.
+ * @param [in] packet_file - Packet file.
+ * @param [in] rq          - RQ sink, or nullptr for the default.
+ * @param [in] tq          - TQ sink, or nullptr for the default.
+ */
+static std::string run_sim(const char *param_file, const char *packet_file, std::unique_ptr<queue_sink> rq,
+                           std::unique_ptr<queue_sink> tq) {
+    nic_sim sim(param_file);
+    if (rq) sim.set_queue_sink(RQ, std::move(rq));
+    if (tq) sim.set_queue_sink(TQ, std::move(tq));
+    sim.nic_flow(packet_file);
+    return capture([&](int fd) { sim.nic_print_results(fd); });
+}
+
+int main(int argc, char **argv) {
+    trace_config config;
+    config.packets = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000;
+    config.seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+    const size_t kept = 16;
+
+    // ring_sink keeping the last packets
+    {
+        ring_sink ring(3);
+        for (int i = 1; i <= 7; ++i) ring.push("packet " + std::to_string(i));
+        std::string text = capture([&](int fd) { fd_writer out(fd); ring.print(out); });
+        check(text == numbered(5, 7), "ring_sink(3) after 7 packets printed:\n" + text);
+
+        ring_sink partial(5);
+        for (int i = 1; i <= 2; ++i) partial.push("packet " + std::to_string(i));
+        text = capture([&](int fd) { fd_writer out(fd); partial.print(out); });
+        check(text == numbered(1, 2), "ring_sink(5) after 2 packets printed:\n" + text);
+    }
+
+    // ring_sink drained to a stream blocks instead of dropping
+    {
+        std::ostringstream out;
+        {
+            ring_sink ring(out, 2);
+            for (int i = 1; i <= 1000; ++i) ring.push("packet " + std::to_string(i));
+        }
+        check(out.str() == numbered(1, 1000), "ring_sink drained through 2 slots lost or reordered packets");
+    }
+
+    // The same trace through each sink
+    const char *param_file = "sink_test_params.txt";
+    const char *packet_file = "sink_test_packets.txt";
+    {
+        trace_generator gen(config);
+        std::ofstream(param_file) << gen.params();
+        std::ofstream out(packet_file);
+        for (const auto &line : gen.packets()) out << line << '\n';
+    }
+
+    results memory(run_sim(param_file, packet_file, nullptr, nullptr));
+    size_t rq_packets = std::count(memory.rq.begin(), memory.rq.end(), '\n');
+    size_t tq_packets = std::count(memory.tq.begin(), memory.tq.end(), '\n');
+
+    {
+        std::ostringstream rq_out, tq_out;
+        results streamed(run_sim(param_file, packet_file, std::make_unique<stream_sink>(rq_out),
+                                 std::make_unique<stream_sink>(tq_out)));
+        check(streamed.rq.empty() && streamed.tq.empty(), "stream_sink packets also printed by nic_print_results");
+        streamed.rq = rq_out.str();
+        streamed.tq = tq_out.str();
+        check(streamed.joined() == memory.joined(), "stream_sink output differs from memory_sink");
+    }
+    {
+        std::ostringstream rq_out, tq_out;
+        results drained(run_sim(param_file, packet_file, std::make_unique<ring_sink>(rq_out, 4),
+                                std::make_unique<ring_sink>(tq_out, 4)));
+        drained.rq = rq_out.str();
+        drained.tq = tq_out.str();
+        check(drained.joined() == memory.joined(), "drained ring_sink output differs from memory_sink");
+    }
+    {
+        results tail(run_sim(param_file, packet_file, std::make_unique<ring_sink>(kept),
+                             std::make_unique<ring_sink>(kept)));
+        check(tail.dram == memory.dram, "LOCAL DRAM differs with ring_sink");
+        check(tail.rq == last_lines(memory.rq, kept), "ring_sink RQ is not the last packets of memory_sink");
+        check(tail.tq == last_lines(memory.tq, kept), "ring_sink TQ is not the last packets of memory_sink");
+    }
+    std::remove(param_file);
+    std::remove(packet_file);
+
+    std::cout << "sink_test: " << rq_packets << " RQ and " << tq_packets << " TQ packets, " << failures
+              << " failures" << std::endl;
+    if (rq_packets <= kept || tq_packets <= kept) {
+        std::cerr << "sink_test: queues shorter than the ring, raise the packet count" << std::endl;
+        return 1;
+    }
+    return failures ? 1 : 0;
+}
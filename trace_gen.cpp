@@ -0,0 +1,129 @@
+#include "trace_gen.hpp"
+#include "L2.h"
+#include "L3.h"
+#include "L4.h"
+#include "packet_format.hpp"
+#include <algorithm>
+#include <cstring>
+
+trace_generator::trace_generator(const trace_config &config_)
+    : config(config_), state(config_.seed), mac{0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc}, ip{10, 0, 1, 5}, mask(20) {
+    config.open_ports = std::max<size_t>(config.open_ports, 1);
+    config.flows = std::max<size_t>(config.flows, 1);
+    config.max_payload = std::max(config.max_payload, config.min_payload);
+    if (config.l2_weight + config.l3_weight + config.l4_weight == 0) config.l4_weight = 1;
+
+    for (size_t i = 0; i < config.open_ports; ++i) {
+        port_src.push_back(static_cast<uint16_t>(1024 + below(60000)));
+        port_dst.push_back(static_cast<uint16_t>(1024 + below(60000)));
+    }
+
+    // Route mix of the L3 flows: 40% local, 20% incoming, 20% outgoing,
+    // 10% transit, 10% internal (dropped by the NIC)
+    flows.resize(config.flows);
+    for (auto &f : flows) {
+        size_t kind = below(10);
+        size_t port = below(config.open_ports);
+        f.src_port = port_src[port];
+        f.dst_port = port_dst[port];
+        if (kind < 4) {
+            random_ip(f.src_ip, false);
+            std::memcpy(f.dst_ip, ip, IP_V4_SIZE);
+        } else {
+            random_ip(f.src_ip, kind == 6 || kind == 7 || kind == 9);
+            random_ip(f.dst_ip, kind == 4 || kind == 5 || kind == 9);
+        }
+    }
+}
+
+uint64_t trace_generator::next() {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+void trace_generator::random_ip(uint8_t out[IP_V4_SIZE], bool in_net) {
+    uint32_t host = static_cast<uint32_t>(next());
+    uint32_t net = pack_ipv4(ip) & prefix_netmask(mask);
+    uint32_t addr = in_net ? net | (host & ~prefix_netmask(mask))
+                           : ((host & ~prefix_netmask(mask)) | ((net ^ 0x80000000u) & prefix_netmask(mask)));
+    for (int i = 0; i < IP_V4_SIZE; ++i) out[i] = static_cast<uint8_t>(addr >> (24 - 8 * i));
+}
+
+std::string trace_generator::params() const {
+    std::string out = l2_packet::mac_to_str(mac) + "\n";
+    for (int i = 0; i < IP_V4_SIZE; ++i) out += std::to_string(ip[i]) + (i + 1 < IP_V4_SIZE ? "." : "");
+    out += "/" + std::to_string(mask) + "\n";
+    for (size_t i = 0; i < port_src.size(); ++i)
+        out += "src_prt:" + std::to_string(port_src[i]) + ", dst_port:" + std::to_string(port_dst[i]) + "\n";
+    return out;
+}
+
+void trace_generator::configure(nic_context &ctx, open_port_vec &open_ports) const {
+    open_ports.clear();
+    for (size_t i = 0; i < port_src.size(); ++i) open_ports.emplace_back(port_dst[i], port_src[i]);
+    ctx = nic_context(open_ports, ip, mask, mac);
+}
+
+std::string trace_generator::make_line(unsigned layer, const flow &f, bool broken) {
+    // Kind of damage for broken packets
+    size_t damage = broken ? below(3) : 3;
+
+    std::vector<uint8_t> data(config.min_payload + below(config.max_payload - config.min_payload + 1));
+    for (auto &byte : data) byte = static_cast<uint8_t>(next());
+    uint32_t address = data.size() <= DATA_ARR_SIZE ? static_cast<uint32_t>(below(DATA_ARR_SIZE - data.size() + 1)) : 0;
+    uint16_t dst_port = f.dst_port;
+    if (damage == 0 && layer == 4) dst_port = static_cast<uint16_t>(dst_port + 1); // Closed port
+    l4_packet l4(f.src_port, dst_port, address, data);
+
+    std::string line(l4.string_size() + 128, '\0');
+    if (layer == 4) {
+        line.resize(l4.write_string(&line[0]) - line.data());
+        return line;
+    }
+
+    uint8_t ttl = static_cast<uint8_t>(damage == 1 ? 0 : 1 + below(64));
+    l3_packet l3(f.src_ip, f.dst_ip, ttl, 0, std::move(l4));
+    l3.checksum = l3_packet::calc_checksum(l3);
+    if (layer == 3 && (damage == 0 || damage == 2)) ++l3.checksum;
+    if (layer == 3) {
+        line.resize(l3.write_string(&line[0]) - line.data());
+        return line;
+    }
+
+    uint8_t dst_mac[MAC_SIZE];
+    std::memcpy(dst_mac, mac, MAC_SIZE);
+    if (damage == 0) dst_mac[MAC_SIZE - 1] ^= 0xFF; // Foreign MAC
+    uint8_t src_mac[MAC_SIZE];
+    for (auto &byte : src_mac) byte = static_cast<uint8_t>(next());
+    l2_packet l2(src_mac, dst_mac, 0, std::move(l3));
+    l2.checksum = l2_packet::calc_checksum(l2);
+    if (damage == 2) ++l2.checksum;
+
+    // L2 text: src_mac|dst_mac|<L3 fields>|checksum
+    char *p = &line[0];
+    p = format_mac(p, l2.src_mac);
+    *p++ = '|';
+    p = format_mac(p, l2.dst_mac);
+    *p++ = '|';
+    p = l2.payload.write_string(p);
+    *p++ = '|';
+    p = format_dec(p, l2.checksum);
+    line.resize(p - line.data());
+    return line;
+}
+
+std::vector<std::string> trace_generator::packets() {
+    std::vector<std::string> lines;
+    lines.reserve(config.packets);
+    unsigned total = config.l2_weight + config.l3_weight + config.l4_weight;
+    size_t hot = std::max<size_t>(config.flows / 16, 1);
+    for (size_t i = 0; i < config.packets; ++i) {
+        size_t pick = below(total);
+        unsigned layer = pick < config.l2_weight ? 2 : pick < config.l2_weight + config.l3_weight ? 3 : 4;
+        const flow &f = flows[chance(config.locality) ? below(hot) : below(flows.size())];
+        lines.push_back(make_line(layer, f, chance(config.drop_ratio)));
+    }
+    return lines;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "packets.hpp"
+#include "nic_context.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @struct trace_config
+ * @brief Shape of a synthetic trace.
+ */
+struct trace_config {
+    size_t packets = 100000;       /**< Number of packet lines */
+    uint64_t seed = 1;             /**< Same seed, same trace */
+    unsigned l2_weight = 1;        /**< Relative share of L2 packets */
+    unsigned l3_weight = 1;        /**< Relative share of L3 packets */
+    unsigned l4_weight = 1;        /**< Relative share of L4 packets */
+    size_t min_payload = 1;        /**< Smallest L4 data size */
+    size_t max_payload = DATA_ARR_SIZE; /**< Largest L4 data size */
+    size_t open_ports = 64;        /**< Open ports in the parameter file */
+    size_t flows = 1024;           /**< Distinct address/port tuples */
+    double locality = 0.8;         /**< Share of packets from the hottest 1/16 of the flows */
+    double drop_ratio = 0.1;       /**< Share of packets made invalid on purpose */
+};
+
+/**
+ * @class trace_generator
+ * @brief Deterministic generator of parameter files and packet traces.
+ *
+ * Flows are split between the routes the NIC distinguishes (local, incoming,
+ * outgoing, transit, internal) and L4 packets target the open ports.
+ * Checksums are computed with l2_packet::calc_checksum and
+ * l3_packet::calc_checksum, so packets are valid unless deliberately
+ * broken: a drop_ratio share gets a wrong checksum, a TTL of 0, a foreign
+ * destination MAC or a closed port. The random source is a fixed
+ * splitmix64, so a trace only depends on the configuration.
+ */
+class trace_generator {
+public:
+    /**
+     * @fn trace_generator
+     * @brief Set up the NIC configuration and flows of a trace.
+     *
+     * @param [in] config - Trace shape.
+     */
+    explicit trace_generator(const trace_config &config);
+
+    /**
+     * @fn params
+     * @brief Parameter file contents (MAC, IP/mask and open ports).
+     */
+    std::string params() const;
+
+    /**
+     * @fn configure
+     * @brief Set up the same configuration params() describes in memory.
+     *
+     * @param [out] ctx        - NIC configuration.
+     * @param [out] open_ports - The NIC's open ports.
+     */
+    void configure(nic_context &ctx, open_port_vec &open_ports) const;
+
+    /**
+     * @fn packets
+     * @brief Generate the packet lines, without line breaks.
+     */
+    std::vector<std::string> packets();
+
+private:
+    struct flow {
+        uint8_t src_ip[IP_V4_SIZE];
+        uint8_t dst_ip[IP_V4_SIZE];
+        uint16_t src_port;
+        uint16_t dst_port;
+    };
+
+    uint64_t next();
+    size_t below(size_t bound) { return bound ? static_cast<size_t>(next() % bound) : 0; }
+    bool chance(double p) { return (next() >> 11) * (1.0 / 9007199254740992.0) < p; }
+    void random_ip(uint8_t ip[IP_V4_SIZE], bool in_net);
+
+    /**
+     * @fn make_line
+     * @brief Build one packet line of the given layer for a flow.
+     */
+    std::string make_line(unsigned layer, const flow &f, bool broken);
+
+    trace_config config;
+    uint64_t state;                      /**< splitmix64 state */
+    uint8_t mac[MAC_SIZE];               /**< NIC's MAC address */
+    uint8_t ip[IP_V4_SIZE];              /**< NIC's IP address */
+    uint8_t mask;                        /**< NIC's mask */
+    std::vector<uint16_t> port_src;      /**< Open ports, source side */
+    std::vector<uint16_t> port_dst;      /**< Open ports, destination side */
+    std::vector<flow> flows;
+};
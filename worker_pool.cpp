@@ -0,0 +1,75 @@
+#include "worker_pool.hpp"
+
+/**
+ * @fn slice_of
+ * @brief Bounds of slice id out of parts over [0, count).
+ */
+static void slice_of(size_t count, unsigned parts, unsigned id, size_t &begin, size_t &end) {
+    begin = count * id / parts;
+    end = count * (id + 1) / parts;
+}
+
+worker_pool::worker_pool(unsigned size)
+    : job(nullptr), count(0), generation(0), pending(0), stopping(false) {
+    for (unsigned id = 1; id < size; ++id)
+        threads.emplace_back(&worker_pool::worker_main, this, id);
+}
+
+worker_pool::~worker_pool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    job_ready.notify_all();
+    for (auto &t : threads) t.join();
+}
+
+void worker_pool::run(size_t count_, const std::function<void(size_t, size_t, unsigned)> &job_) {
+    if (count_ == 0) return;
+    if (threads.empty()) {
+        job_(0, count_, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        job = &job_;
+        count = count_;
+        pending = static_cast<unsigned>(threads.size());
+        ++generation;
+    }
+    job_ready.notify_all();
+
+    size_t begin, end;
+    slice_of(count_, size(), 0, begin, end);
+    job_(begin, end, 0);
+
+    std::unique_lock<std::mutex> guard(lock);
+    job_done.wait(guard, [this] { return pending == 0; });
+    job = nullptr;
+}
+
+void worker_pool::worker_main(unsigned id) {
+    unsigned seen = 0;
+    while (true) {
+        const std::function<void(size_t, size_t, unsigned)> *cur;
+        size_t cur_count;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            job_ready.wait(guard, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            cur = job;
+            cur_count = count;
+        }
+
+        size_t begin, end;
+        slice_of(cur_count, size(), id, begin, end);
+        if (begin < end) (*cur)(begin, end, id);
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (--pending == 0) job_done.notify_one();
+        }
+    }
+}
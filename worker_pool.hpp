@@ -0,0 +1,70 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class worker_pool
+ * @brief Fixed-size pool of threads that split an index range between them.
+ *
+ * The calling thread takes part in every job, so a pool of size 1 runs jobs
+ * inline without starting any thread.
+ */
+class worker_pool {
+public:
+    /**
+     * @fn worker_pool
+     * @brief Start the pool.
+     *
+     * @param [in] size - Number of threads working on each job (including
+     *                    the calling thread). 0 is treated as 1.
+     */
+    explicit worker_pool(unsigned size);
+
+    /**
+     * @fn ~worker_pool
+     * @brief Stop and join all threads.
+     */
+    ~worker_pool();
+
+    worker_pool(const worker_pool &) = delete;
+    worker_pool &operator=(const worker_pool &) = delete;
+
+    /**
+     * @fn size
+     * @brief Number of threads working on each job.
+     */
+    unsigned size() const { return static_cast<unsigned>(threads.size()) + 1; }
+
+    /**
+     * @fn run
+     * @brief Split [0, count) into contiguous slices, one per thread, call
+     *        job(begin, end, worker) on each slice and wait until all are
+     *        done. worker is the index (0 to size() - 1) of the thread
+     *        running the slice, for per-thread state.
+     *
+     * @param [in] count - Size of the index range.
+     * @param [in] job   - Function called on every slice.
+     */
+    void run(size_t count, const std::function<void(size_t, size_t, unsigned)> &job);
+
+private:
+    /**
+     * @fn worker_main
+     * @brief Thread body: wait for a job, run its slice, report completion.
+     */
+    void worker_main(unsigned id);
+
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    std::condition_variable job_ready;
+    std::condition_variable job_done;
+    const std::function<void(size_t, size_t, unsigned)> *job;
+    size_t count;
+    unsigned generation;  /**< Incremented for every new job */
+    unsigned pending;     /**< Threads still working on the current job */
+    bool stopping;
+};